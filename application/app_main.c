@@ -13,6 +13,8 @@
 #include "rtthread.h"
 #include "ch32f205_dap.h"
 #include "ch32f205_watchdog.h"
+#include "ch32f205_rt_thread.h"
+#include "ch32f205_time.h"
 
 //void dap_test(void);
 
@@ -26,11 +28,13 @@
 int main(void)
 {   
     dap_init();
+    dap_hrtimer_service_init();
     thread_ipc_int();
     usb_interface_init();
     usart_dma_init();
     dap_iwatchdog_init();
     rt_thread_idle_sethook(dap_iwdg_reload);
+    rt_thread_idle_sethook(dap_tickless_idle);
     //dap_test();
 
     return RT_EOK;
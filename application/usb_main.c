@@ -6,10 +6,15 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-11     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       run DAP background services between requests.
+ * 2026-10-18     SecondHandCoder       add notify interrupt endpoint.
+ * 2026-10-18     SecondHandCoder       add RTT CDC ACM interface.
+ * 2026-10-18     SecondHandCoder       stream boundary scan samples on the RTT interface.
  */
 
 #include "usb_main.h"
 #include "dap_main.h"
+#include "dap_vendor.h"
 #include "completion.h"
 #include "ringbuffer.h"
 #include "rthw.h"
@@ -74,17 +79,35 @@ static usart_cdc_info_t usart_cdc_info;
 struct usbd_interface dap_intf;
 struct usbd_interface intf1;
 struct usbd_interface intf2;
+struct usbd_interface notify_intf;
+struct usbd_interface rtt_intf1;
+struct usbd_interface rtt_intf2;
 
 /* ch32 USB receive and send buffers require 4-byte alignment
  * If there is no alignment requirement, the buffer can be omitted 
  * and the data can be directly manipulated in the ringbuffer */
 static USB_MEM_ALIGNX uint8_t usb_cdc_rev_buff[DAP_PACKET_SIZE];
 static USB_MEM_ALIGNX uint8_t usb_cdc_send_buff[DAP_PACKET_SIZE];
+#if (DAP_NOTIFY != 0)
+static USB_MEM_ALIGNX uint8_t usb_notify_buff[NOTIFY_EP_SIZE];
+static volatile uint8_t usb_notify_busy = 0;
+#endif
+#if (DAP_RTT != 0)
+static USB_MEM_ALIGNX uint8_t usb_rtt_rev_buff[DAP_PACKET_SIZE];
+static USB_MEM_ALIGNX uint8_t usb_rtt_send_buff[DAP_PACKET_SIZE];
+static volatile uint8_t usb_rtt_busy = 0;
+static volatile uint32_t usb_rtt_rev_len = 0;
+static uint32_t usb_rtt_rev_ptr = 0;
+#endif
 
 /* default serial config 115200 8-n-1 */
 #if (DAP_UART != 0)
 static struct cdc_line_coding g_cdc_lincoding = {115200, 0, 0, 8};
 #endif
+/* RTT line coding is only kept for the host, it has no effect */
+#if (DAP_RTT != 0)
+static struct cdc_line_coding g_rtt_lincoding = {115200, 0, 0, 8};
+#endif
 
 /* USB CDC convert data ringbuffer size */
 #define USB2USART_RINGBUFFER_SIZE   (4 * 1024)
@@ -94,6 +117,13 @@ static void dap_out_callback(uint8_t ep, uint32_t nbytes);
 static void dap_in_callback(uint8_t ep, uint32_t nbytes);
 static void usbd_cdc_acm_bulk_out(uint8_t ep, uint32_t nbytes);
 static void usbd_cdc_acm_bulk_in(uint8_t ep, uint32_t nbytes);
+#if (DAP_NOTIFY != 0)
+static void usb_notify_in(uint8_t ep, uint32_t nbytes);
+#endif
+#if (DAP_RTT != 0)
+static void usb_rtt_out(uint8_t ep, uint32_t nbytes);
+static void usb_rtt_in(uint8_t ep, uint32_t nbytes);
+#endif
 
 static struct usbd_endpoint dap_out_ep =
 {
@@ -119,6 +149,28 @@ static struct usbd_endpoint cdc_in_ep =
     .ep_cb = usbd_cdc_acm_bulk_in
 };
 
+#if (DAP_NOTIFY != 0)
+static struct usbd_endpoint notify_in_ep =
+{
+    .ep_addr = NOTIFY_INT_EP,
+    .ep_cb = usb_notify_in
+};
+#endif
+
+#if (DAP_RTT != 0)
+static struct usbd_endpoint rtt_out_ep =
+{
+    .ep_addr = RTT_OUT_EP,
+    .ep_cb = usb_rtt_out
+};
+
+static struct usbd_endpoint rtt_in_ep =
+{
+    .ep_addr = RTT_IN_EP,
+    .ep_cb = usb_rtt_in
+};
+#endif
+
 
 /**
  * @brief Get a linear block of data from the ring buffer.
@@ -365,6 +417,110 @@ static void usbd_cdc_acm_bulk_in(uint8_t ep, uint32_t nbytes)
     }      
 }
 
+/**
+ * @brief USB notify has data sent.
+ *
+ * @param ep            USB endpoint.
+ * @param nbytes        The size of the data sent.
+ *
+ * @return None.
+ */
+#if (DAP_NOTIFY != 0)
+static void usb_notify_in(uint8_t ep, uint32_t nbytes)
+{
+    usb_notify_busy = 0;
+}
+
+/**
+ * @brief Send the pending DAP notification when the notify endpoint is free.
+ *
+ * @return None.
+ */
+static void usb_dap_notify(void)
+{
+    uint16_t len;
+
+    if (usb_notify_busy)
+        return;
+    len = dap_vendor_notify_get(usb_notify_buff, NOTIFY_EP_SIZE);
+    if (len)
+    {
+        usb_notify_busy = 1;
+        usbd_ep_start_write(NOTIFY_INT_EP, usb_notify_buff, len);
+    }
+}
+#endif
+
+/**
+ * @brief USB RTT has data received, dropped at once while RTT is stopped.
+ *
+ * @param ep            USB endpoint.
+ * @param nbytes        The size of the data received.
+ *
+ * @return None.
+ */
+#if (DAP_RTT != 0)
+static void usb_rtt_out(uint8_t ep, uint32_t nbytes)
+{
+    if (nbytes && dap_vendor_rtt_active())
+        usb_rtt_rev_len = nbytes;
+    else
+        usbd_ep_start_read(RTT_OUT_EP, usb_rtt_rev_buff, DAP_PACKET_SIZE);
+}
+
+/**
+ * @brief USB RTT has data sent.
+ *
+ * @param ep            USB endpoint.
+ * @param nbytes        The size of the data sent.
+ *
+ * @return None.
+ */
+static void usb_rtt_in(uint8_t ep, uint32_t nbytes)
+{
+    if (((nbytes % DAP_PACKET_SIZE) == 0) && (nbytes))
+    {
+        /* send zlp */
+        usbd_ep_start_write(RTT_IN_EP, NULL, 0);
+    }
+    else
+    {
+        usb_rtt_busy = 0;
+    }
+}
+
+/**
+ * @brief Move RTT data between the target and the RTT endpoints, runs in the DAP thread.
+ *
+ * @return None.
+ */
+static void usb_rtt_transfer(void)
+{
+    uint16_t len;
+
+    if (!usb_rtt_busy)
+    {
+        len = dap_vendor_rtt_read(usb_rtt_send_buff, DAP_PACKET_SIZE);
+        if (!len)
+            len = dap_vendor_bscan_read(usb_rtt_send_buff, DAP_PACKET_SIZE);
+        if (len)
+        {
+            usb_rtt_busy = 1;
+            usbd_ep_start_write(RTT_IN_EP, usb_rtt_send_buff, len);
+        }
+    }
+    if (usb_rtt_rev_len)
+    {
+        usb_rtt_rev_ptr += dap_vendor_rtt_write(usb_rtt_rev_buff + usb_rtt_rev_ptr, usb_rtt_rev_len - usb_rtt_rev_ptr);
+        if (usb_rtt_rev_ptr >= usb_rtt_rev_len)
+        {
+            usb_rtt_rev_ptr = 0;
+            usb_rtt_rev_len = 0;
+            usbd_ep_start_read(RTT_OUT_EP, usb_rtt_rev_buff, DAP_PACKET_SIZE);
+        }
+    }
+}
+#endif
 
 /**
  * @brief USB DAP request thread.
@@ -425,7 +581,17 @@ static void usb_dap_res_thread(void *arg)
 }
 
 /**
- * @brief USB DAP data process thread.
+ * @brief USB DAP request is waiting for process.
+ *
+ * @return 1 : pending.
+ */
+static uint8_t usb_dap_request_pending(void)
+{
+    return (usb_dap_reqinfo.usb_req_mailbox->entry != 0);
+}
+
+/**
+ * @brief USB DAP data process thread, background services run between requests.
  *
  * @param arg           thread arg.
  * 
@@ -434,10 +600,11 @@ static void usb_dap_res_thread(void *arg)
 static void dap_process_thread(void *arg)
 {
     usb_transfer_t *usb_transfer;
+    rt_int32_t wait = RT_WAITING_FOREVER;
     
     while (1)
     {
-        if (rt_mb_recv(usb_dap_reqinfo.usb_req_mailbox, (rt_ubase_t *)&usb_transfer, RT_WAITING_FOREVER) == RT_EOK)
+        if (rt_mb_recv(usb_dap_reqinfo.usb_req_mailbox, (rt_ubase_t *)&usb_transfer, wait) == RT_EOK)
         {
             usb_dap_resinfo.cur_res_buffer = (usb_transfer_t *)rt_mp_alloc(usb_dap_resinfo.usb_res_mempool, RT_WAITING_FOREVER);
             usb_dap_resinfo.cur_res_buffer->buffer_size = dap_request_handler(usb_transfer->buffer,
@@ -445,6 +612,13 @@ static void dap_process_thread(void *arg)
             rt_mp_free(usb_transfer);
             rt_mb_send_wait(usb_dap_resinfo.usb_res_mailbox, (rt_ubase_t)usb_dap_resinfo.cur_res_buffer, RT_WAITING_FOREVER);
 		}
+        wait = dap_vendor_service(usb_dap_request_pending);
+#if (DAP_NOTIFY != 0)
+        usb_dap_notify();
+#endif
+#if (DAP_RTT != 0)
+        usb_rtt_transfer();
+#endif
     }
 }
 
@@ -605,6 +779,18 @@ void usb_interface_init(void)
     usbd_add_endpoint(&cdc_out_ep);
     usbd_add_endpoint(&cdc_in_ep);
 #endif       
+    /*!< notify */
+#if (DAP_NOTIFY != 0)
+    usbd_add_interface(&notify_intf);
+    usbd_add_endpoint(&notify_in_ep);
+#endif
+    /*!< rtt cdc acm */
+#if (DAP_RTT != 0)
+    usbd_add_interface(usbd_cdc_acm_init_intf(&rtt_intf1));
+    usbd_add_interface(usbd_cdc_acm_init_intf(&rtt_intf2));
+    usbd_add_endpoint(&rtt_out_ep);
+    usbd_add_endpoint(&rtt_in_ep);
+#endif
     usbd_initialize();
 }
 
@@ -711,6 +897,15 @@ void usb_transfer_start(void)
 #if (DAP_UART != 0)    
     usbd_ep_start_read(CDC_OUT_EP, usb_cdc_rev_buff, DAP_PACKET_SIZE);
 #endif
+#if (DAP_NOTIFY != 0)
+    usb_notify_busy = 0;
+#endif
+#if (DAP_RTT != 0)
+    usb_rtt_busy = 0;
+    usb_rtt_rev_len = 0;
+    usb_rtt_rev_ptr = 0;
+    usbd_ep_start_read(RTT_OUT_EP, usb_rtt_rev_buff, DAP_PACKET_SIZE);
+#endif
 }
 
 /**
@@ -721,9 +916,17 @@ void usb_transfer_start(void)
  *
  * @return None.
  */
-#if (DAP_UART != 0)
+#if (DAP_UART != 0) || (DAP_RTT != 0)
 void usbd_cdc_acm_set_line_coding(uint8_t intf, struct cdc_line_coding *line_coding)
 {
+#if (DAP_RTT != 0)
+    if (intf == RTT_INTF)
+    {
+        rt_memcpy((uint8_t *)&g_rtt_lincoding, line_coding, sizeof(struct cdc_line_coding));
+        return;
+    }
+#endif
+#if (DAP_UART != 0)
     if (rt_memcmp(line_coding, (uint8_t *)&g_cdc_lincoding, sizeof(struct cdc_line_coding)) != 0)
     {
         rt_memcpy((uint8_t *)&g_cdc_lincoding, line_coding, sizeof(struct cdc_line_coding));
@@ -744,6 +947,7 @@ void usbd_cdc_acm_set_line_coding(uint8_t intf, struct cdc_line_coding *line_cod
         usart_param_config(g_cdc_lincoding.dwDTERate, g_cdc_lincoding.bDataBits, g_cdc_lincoding.bCharFormat, g_cdc_lincoding.bParityType);
         dma_param_config(&usart_cdc_info.rb_usart2usb->buffer_ptr[0], USART2USB_RINGBUFFER_SIZE);
     }   
+#endif
 }
 #endif
 
@@ -755,9 +959,18 @@ void usbd_cdc_acm_set_line_coding(uint8_t intf, struct cdc_line_coding *line_cod
  *
  * @return None.
  */
-#if (DAP_UART != 0)
+#if (DAP_UART != 0) || (DAP_RTT != 0)
 void usbd_cdc_acm_get_line_coding(uint8_t intf, struct cdc_line_coding *line_coding)
 {
+#if (DAP_RTT != 0)
+    if (intf == RTT_INTF)
+    {
+        rt_memcpy(line_coding, (uint8_t *)&g_rtt_lincoding, sizeof(struct cdc_line_coding));
+        return;
+    }
+#endif
+#if (DAP_UART != 0)
     rt_memcpy(line_coding, (uint8_t *)&g_cdc_lincoding, sizeof(struct cdc_line_coding));
+#endif
 }
 #endif
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-22     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       keep the other APB1 clocks enabled.
  */
 
 #include "ch32f205_backup.h"
@@ -19,7 +20,7 @@
  */
 uint16_t get_backup_data(void)
 {
-	RCC->APB1PCENR = RCC_BKPEN | RCC_PWREN;
+	RCC->APB1PCENR |= RCC_BKPEN | RCC_PWREN;
 	uint16_t value = BKP->DATAR1;
     RCC->APB1PCENR &= ~(RCC_BKPEN | RCC_PWREN);
 	return value;
@@ -34,7 +35,7 @@ uint16_t get_backup_data(void)
  */
 void set_backup_data(uint16_t word)
 {
-    RCC->APB1PCENR = RCC_BKPEN | RCC_PWREN;
+    RCC->APB1PCENR |= RCC_BKPEN | RCC_PWREN;
     PWR->CTLR = PWR_CTLR_DBP;
     BKP->DATAR1 = word;
     PWR->CTLR &= ~PWR_CTLR_DBP;
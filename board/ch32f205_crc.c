@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-22     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       enable CRC clock before reset.
  */
 
 #include "ch32f205_crc.h"
@@ -19,6 +20,7 @@
  */
 void crc_cal_reset(void)
 {
+    RCC->AHBPCENR |= RCC_CRCEN;
     CRC->CTLR = CRC_CTLR_RESET;
 }
 
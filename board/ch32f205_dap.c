@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-12     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       add JTAG timer and DMA waveform engine.
+ * 2026-10-18     SecondHandCoder       add JTAG SPI shifts by DMA.
  */
 
 #include "ch32f205_dap.h"
@@ -483,6 +485,9 @@ void dap_jtag_io_reconfig(void)
 void dap_jtag_trans_init(void)
 {
     JTAG_SPI_RCC_EN();   
+#if (DAP_JTAG_SPI_DMA != 0)
+    JTAG_SPI_DMA_RCC_EN();
+#endif
 }
 
 /**
@@ -496,6 +501,203 @@ void dap_jtag_trans_deinit(void)
     JTAG_SPI_BASE->CTLR2 = 0;
     JTAG_SPI_RCC_DIS();
 }
+
+#if (DAP_JTAG_SPI_DMA != 0)
+/**
+ * @brief JTAG shift bytes by SPI with DMA, RX has the higher priority so TDO
+ *        is never overrun, TDI and TDO may be the same buffer.
+ *
+ * @param bytes         Num of bytes.
+ * @param tdi           A pointer to the tdi data buffer.
+ * @param tdo           A pointer to the tdo data buffer.
+ *
+ * @return None.
+ */
+void dap_jtag_spi_dma(uint32_t bytes, const uint8_t *tdi, uint8_t *tdo)
+{
+    (void)JTAG_READ_DATA();
+
+    JTAG_SPI_RX_CHANNEL->CFGR = 0;
+    JTAG_SPI_RX_CHANNEL->CNTR = bytes;
+    JTAG_SPI_RX_CHANNEL->PADDR = (uint32_t)(&JTAG_SPI_BASE->DATAR);
+    JTAG_SPI_RX_CHANNEL->MADDR = (uint32_t)tdo;
+    JTAG_SPI_RX_CHANNEL->CFGR = DMA_CFGR1_MINC | DMA_CFGR1_PL | DMA_CFGR1_EN;
+
+    JTAG_SPI_TX_CHANNEL->CFGR = 0;
+    JTAG_SPI_TX_CHANNEL->CNTR = bytes;
+    JTAG_SPI_TX_CHANNEL->PADDR = (uint32_t)(&JTAG_SPI_BASE->DATAR);
+    JTAG_SPI_TX_CHANNEL->MADDR = (uint32_t)tdi;
+    JTAG_SPI_TX_CHANNEL->CFGR = DMA_CFGR1_DIR | DMA_CFGR1_MINC | DMA_CFGR1_EN;
+
+    JTAG_SPI_DMA_CLR_STATUS();
+    JTAG_SPI_BASE->CTLR2 |= SPI_CTLR2_RXDMAEN;
+    JTAG_SPI_BASE->CTLR2 |= SPI_CTLR2_TXDMAEN;
+
+    while (!JTAG_SPI_RX_GET_STATUS());
+
+    JTAG_SPI_BASE->CTLR2 &= ~(SPI_CTLR2_RXDMAEN | SPI_CTLR2_TXDMAEN);
+    JTAG_SPI_RX_CHANNEL->CFGR = 0;
+    JTAG_SPI_TX_CHANNEL->CFGR = 0;
+    JTAG_SPI_DMA_CLR_STATUS();
+}
+#endif
+
+#if (DAP_JTAG_WAVE != 0)
+/* Max bits of one waveform run */
+#define JTAG_WAVE_BITS                                      64U
+
+static uint32_t jtag_wave_tck_tdi[JTAG_WAVE_BITS];         /* GPIO BSHR, TCK low and TDI level of each bit */
+static uint32_t jtag_wave_tms[JTAG_WAVE_BITS];             /* GPIO BSHR, TMS level of each bit */
+static uint16_t jtag_wave_tdo[JTAG_WAVE_BITS];             /* GPIO INDR sampled at the end of each bit */
+static const uint32_t jtag_wave_tck_high = PERIPHERAL_GPIO_TCK_JTAG_PIN;
+static struct rt_semaphore jtag_wave_sem;                  /* released by the TDO channel transfer complete */
+static uint16_t jtag_wave_khz;                             /* engine clock unit khz, 0 : not initialized */
+
+/**
+ * @brief DMA interrupt handle of the TDO channel, the last bit is sampled and the run is over.
+ *        The SPI DMA shares the channel without the interrupt enabled.
+ *
+ * @return None.
+ */
+void JTAG_WAVE_TDO_HANDLE(void)
+{
+    rt_interrupt_enter();
+    if (JTAG_WAVE_TDO_GET_STATUS())
+    {
+        JTAG_WAVE_CLR_STATUS();
+        rt_sem_release(&jtag_wave_sem);
+    }
+    rt_interrupt_leave();
+}
+
+/**
+ * @brief JTAG waveform engine init, the bit period is timed by the timer:
+ *        CH1 at tick 1         - TCK low and TDI level,
+ *        CH2 at tick 1         - TMS level,
+ *        CH4 at half period    - TCK high,
+ *        update at the end     - TDO sampled.
+ *
+ * @param clk           Clock frequency to be set unit khz.
+ *
+ * @return 1 : JTAG is clocked by the engine, 0 : clock out of the engine range.
+ */
+uint8_t dap_jtag_wave_init(uint16_t clk)
+{
+    uint32_t ticks, psc;
+
+    if (!clk || (clk >= JTAG_WAVE_MAX_KHZ))
+        return 0;
+
+    if (!jtag_wave_khz)
+    {
+        rt_sem_init(&jtag_wave_sem, "jwave", 0, RT_IPC_FLAG_FIFO);
+        NVIC_SetPriority(JTAG_WAVE_TDO_VECTOR, 4);
+        NVIC_EnableIRQ(JTAG_WAVE_TDO_VECTOR);
+    }
+    jtag_wave_khz = clk;
+
+    JTAG_WAVE_TIM_RCC_EN();
+    JTAG_WAVE_DMA_RCC_EN();
+
+    ticks = JTAG_WAVE_TIM_CLK / ((uint32_t)clk * 1000U);
+    psc = (ticks >> 16) + 1;
+    ticks /= psc;
+
+    JTAG_WAVE_TIM->CTLR1 = TIM_URS;
+    JTAG_WAVE_TIM->DMAINTENR = 0;
+    JTAG_WAVE_TIM->PSC = psc - 1;
+    JTAG_WAVE_TIM->ATRLR = ticks - 1;
+    JTAG_WAVE_TIM->CH1CVR = 1;
+    JTAG_WAVE_TIM->CH2CVR = 1;
+    JTAG_WAVE_TIM->CH4CVR = (ticks >> 1) + 1;
+    JTAG_WAVE_TIM->SWEVGR = TIM_UG;
+    JTAG_WAVE_TIM->INTFR = 0;
+    return 1;
+}
+
+/**
+ * @brief JTAG write/read by the waveform engine, the clock is exact and not
+ *        stretched by interrupts, TCK is left high as by the IO simulation.
+ *        The calling thread sleeps until the TDO channel completes.
+ *
+ * @param bitlen        Len of instruction, JTAG_WAVE_BITS max.
+ * @param tms           A pointer to the tms data buffer.
+ * @param tdi           A pointer to the tdi data buffer.
+ * @param tdo           A pointer to the tdo data buffer.
+ *
+ * @return None.
+ */
+void dap_jtag_wave_rw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    uint32_t i;
+
+    if (bitlen > JTAG_WAVE_BITS)
+        bitlen = JTAG_WAVE_BITS;
+
+    for (i = 0; i < bitlen; i++)
+    {
+        if ((tdi[i >> 3] >> (i & 0x7)) & 0x1)
+            jtag_wave_tck_tdi[i] = (PERIPHERAL_GPIO_TCK_JTAG_PIN << 16) | PERIPHERAL_GPIO_TDI_PIN;
+        else
+            jtag_wave_tck_tdi[i] = (PERIPHERAL_GPIO_TCK_JTAG_PIN << 16) | (PERIPHERAL_GPIO_TDI_PIN << 16);
+
+        if ((tms[i >> 3] >> (i & 0x7)) & 0x1)
+            jtag_wave_tms[i] = PERIPHERAL_GPIO_TMS_MO_PIN;
+        else
+            jtag_wave_tms[i] = PERIPHERAL_GPIO_TMS_MO_PIN << 16;
+    }
+
+    JTAG_WAVE_TCK_TDI_CHANNEL->CFGR = 0;
+    JTAG_WAVE_TCK_TDI_CHANNEL->CNTR = bitlen;
+    JTAG_WAVE_TCK_TDI_CHANNEL->PADDR = (uint32_t)(&PERIPHERAL_GPIO_TDI_IDX->BSHR);
+    JTAG_WAVE_TCK_TDI_CHANNEL->MADDR = (uint32_t)jtag_wave_tck_tdi;
+    JTAG_WAVE_TCK_TDI_CHANNEL->CFGR = DMA_CFGR1_DIR | DMA_CFGR1_MINC | DMA_CFGR1_PSIZE_1 | DMA_CFGR1_MSIZE_1 | DMA_CFGR1_PL | DMA_CFGR1_EN;
+
+    JTAG_WAVE_TMS_CHANNEL->CFGR = 0;
+    JTAG_WAVE_TMS_CHANNEL->CNTR = bitlen;
+    JTAG_WAVE_TMS_CHANNEL->PADDR = (uint32_t)(&PERIPHERAL_GPIO_TMS_MO_IDX->BSHR);
+    JTAG_WAVE_TMS_CHANNEL->MADDR = (uint32_t)jtag_wave_tms;
+    JTAG_WAVE_TMS_CHANNEL->CFGR = DMA_CFGR1_DIR | DMA_CFGR1_MINC | DMA_CFGR1_PSIZE_1 | DMA_CFGR1_MSIZE_1 | DMA_CFGR1_PL | DMA_CFGR1_EN;
+
+    JTAG_WAVE_TCK_HIGH_CHANNEL->CFGR = 0;
+    JTAG_WAVE_TCK_HIGH_CHANNEL->CNTR = bitlen;
+    JTAG_WAVE_TCK_HIGH_CHANNEL->PADDR = (uint32_t)(&PERIPHERAL_GPIO_TCK_JTAG_IDX->BSHR);
+    JTAG_WAVE_TCK_HIGH_CHANNEL->MADDR = (uint32_t)&jtag_wave_tck_high;
+    JTAG_WAVE_TCK_HIGH_CHANNEL->CFGR = DMA_CFGR1_DIR | DMA_CFGR1_PSIZE_1 | DMA_CFGR1_MSIZE_1 | DMA_CFGR1_PL | DMA_CFGR1_EN;
+
+    JTAG_WAVE_TDO_CHANNEL->CFGR = 0;
+    JTAG_WAVE_TDO_CHANNEL->CNTR = bitlen;
+    JTAG_WAVE_TDO_CHANNEL->PADDR = (uint32_t)(&PERIPHERAL_GPIO_TDO_IDX->INDR);
+    JTAG_WAVE_TDO_CHANNEL->MADDR = (uint32_t)jtag_wave_tdo;
+    JTAG_WAVE_TDO_CHANNEL->CFGR = DMA_CFGR1_MINC | DMA_CFGR1_PSIZE_0 | DMA_CFGR1_MSIZE_0 | DMA_CFGR1_PL | DMA_CFGR1_TCIE | DMA_CFGR1_EN;
+
+    JTAG_WAVE_CLR_STATUS();
+    rt_sem_control(&jtag_wave_sem, RT_IPC_CMD_RESET, RT_NULL);
+    JTAG_WAVE_TIM->CNT = 0;
+    JTAG_WAVE_TIM->INTFR = 0;
+    JTAG_WAVE_TIM->DMAINTENR = TIM_CC1DE | TIM_CC2DE | TIM_CC4DE | TIM_UDE;
+    JTAG_WAVE_TIM->CTLR1 |= TIM_CEN;
+
+    // a stalled run is stopped after twice its time, the TDO bits read as sampled so far
+    rt_sem_take(&jtag_wave_sem, rt_tick_from_millisecond((bitlen << 1) / jtag_wave_khz + 2U));
+
+    JTAG_WAVE_TIM->CTLR1 &= ~TIM_CEN;
+    JTAG_WAVE_TIM->DMAINTENR = 0;
+    JTAG_WAVE_TCK_TDI_CHANNEL->CFGR = 0;
+    JTAG_WAVE_TMS_CHANNEL->CFGR = 0;
+    JTAG_WAVE_TCK_HIGH_CHANNEL->CFGR = 0;
+    JTAG_WAVE_TDO_CHANNEL->CFGR = 0;
+    JTAG_WAVE_CLR_STATUS();
+
+    for (i = 0; i < ((bitlen + 7) >> 3); i++)
+        tdo[i] = 0;
+    for (i = 0; i < bitlen; i++)
+    {
+        if (jtag_wave_tdo[i] & PERIPHERAL_GPIO_TDO_PIN)
+            tdo[i >> 3] |= 0x1 << (i & 0x7);
+    }
+}
+#endif
 #endif
 
 #if (DAP_UART != 0)
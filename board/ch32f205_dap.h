@@ -307,6 +307,31 @@ extern "C" {
 #define JTAG_READ_DATA()                                    (JTAG_SPI_BASE->DATAR)
 #define JTAG_WAIT_BUSY()                                    (JTAG_SPI_BASE->STATR & SPI_STATR_BSY)
 
+// JTAG SPI DMA, SPI2 RX/TX requests DMA1 channel 4/5, shared with the waveform engine which never runs together with SPI
+#define JTAG_SPI_DMA_MIN_BYTES                              16U
+#define JTAG_SPI_DMA                                        DMA1
+#define JTAG_SPI_DMA_RCC_EN()                               (RCC->AHBPCENR |= RCC_DMA1EN)
+#define JTAG_SPI_RX_CHANNEL                                 DMA1_Channel4
+#define JTAG_SPI_TX_CHANNEL                                 DMA1_Channel5
+#define JTAG_SPI_RX_GET_STATUS()                            (JTAG_SPI_DMA->INTFR & DMA_TCIF4)
+#define JTAG_SPI_DMA_CLR_STATUS()                           (JTAG_SPI_DMA->INTFCR = DMA_CGIF4 | DMA_CGIF5)
+
+// JTAG waveform engine, TIM1 CH1/CH2/CH4/UP requests DMA1 channel 2/3/4/5, TCK and TDI share one port
+#define JTAG_WAVE_MAX_KHZ                                   1125U
+#define JTAG_WAVE_TIM                                       TIM1
+#define JTAG_WAVE_TIM_CLK                                   Pclk2Clock
+#define JTAG_WAVE_TIM_RCC_EN()                              (RCC->APB2PCENR |= RCC_TIM1EN)
+#define JTAG_WAVE_DMA                                       DMA1
+#define JTAG_WAVE_DMA_RCC_EN()                              (RCC->AHBPCENR |= RCC_DMA1EN)
+#define JTAG_WAVE_TCK_TDI_CHANNEL                           DMA1_Channel2
+#define JTAG_WAVE_TMS_CHANNEL                               DMA1_Channel3
+#define JTAG_WAVE_TCK_HIGH_CHANNEL                          DMA1_Channel4
+#define JTAG_WAVE_TDO_CHANNEL                               DMA1_Channel5
+#define JTAG_WAVE_TDO_GET_STATUS()                          (JTAG_WAVE_DMA->INTFR & DMA_TCIF5)
+#define JTAG_WAVE_TDO_VECTOR                                DMA1_Channel5_IRQn
+#define JTAG_WAVE_TDO_HANDLE                                DMA1_Channel5_IRQHandler
+#define JTAG_WAVE_CLR_STATUS()                              (JTAG_WAVE_DMA->INTFCR = DMA_CGIF2 | DMA_CGIF3 | DMA_CGIF4 | DMA_CGIF5)
+
 
 // USART
 #define PERIPHERAL_GPIO_USART_RX_IDX                        GPIOA
@@ -378,6 +403,13 @@ extern void dap_jtag_gpio_deinit(void);
 extern void dap_jtag_io_reconfig(void);
 extern void dap_jtag_trans_init(void);
 extern void dap_jtag_trans_deinit(void);
+#if (DAP_JTAG_SPI_DMA != 0)
+extern void dap_jtag_spi_dma(uint32_t bytes, const uint8_t *tdi, uint8_t *tdo);
+#endif
+#if (DAP_JTAG_WAVE != 0)
+extern uint8_t dap_jtag_wave_init(uint16_t clk);
+extern void dap_jtag_wave_rw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
+#endif
 #endif
 #if (DAP_UART != 0)
 extern void usart_gpio_init(void);
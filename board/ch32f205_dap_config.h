@@ -12,7 +12,17 @@
 
 /// Configure maximum number of JTAG devices on the scan chain connected to the Debug Access Port.
 /// This setting impacts the RAM requirements of the Debug Unit. Valid range is 1 .. 255.
-#define DAP_JTAG_DEV_CNT        4U              ///< Maximum number of JTAG devices on scan chain.
+#define DAP_JTAG_DEV_CNT        32U             ///< Maximum number of JTAG devices on scan chain.
+
+/// Configure maximum number of SWD multi-drop targets in the probe side target table.
+#define DAP_SWD_TARGET_CNT      8U              ///< Maximum number of SWD multi-drop targets.
+
+/// Indicate that JTAG clocks below the slowest SPI setting are timed by the timer and DMA waveform engine.
+/// The engine covers the whole scan at those clocks, at SPI clocks the head and tail bits stay bit-banged.
+#define DAP_JTAG_WAVE           1U              ///< JTAG waveform engine:  1 = available, 0 = not available.
+
+/// Indicate that long JTAG SPI shifts are moved by DMA instead of polling each byte.
+#define DAP_JTAG_SPI_DMA        1U              ///< JTAG SPI DMA:  1 = available, 0 = not available.
 
 /// Default communication mode on the Debug Access Port.
 /// Used for the command \ref DAP_Connect when Port Default mode is selected.
@@ -44,4 +54,14 @@
 #define DAP_UART                1U              ///< DAP UART:  1 = available, 0 = not available.
 #endif
 
+/// Indicate that the notify interrupt endpoint is available, used to report target halt events.
+#ifndef __BUILD_BOOT__
+#define DAP_NOTIFY              1U              ///< DAP notify:  1 = available, 0 = not available.
+#endif
+
+/// Indicate that the RTT CDC ACM interface is available, used to stream the target RTT channels.
+#ifndef __BUILD_BOOT__
+#define DAP_RTT                 1U              ///< DAP RTT:  1 = available, 0 = not available.
+#endif
+
 #endif /* __DAP_CONFIG_H__ */
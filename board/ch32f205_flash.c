@@ -6,16 +6,39 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-22     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       fix page alignment check and busy timeouts.
+ * 2026-10-18     SecondHandCoder       add 4K/32K/64K block erase.
  */
 
 #include "ch32f205_flash.h"
 #include "ch32f20x.h"
+#include "ch32f205_memory.h"
 
 #define FLASH_KEY1               ((uint32_t)0x45670123)
 #define FLASH_KEY2               ((uint32_t)0xCDEF89AB)
 
 #define ERASE_TIME_OUT           ((uint32_t)0x000B0000)
 #define PROGRAM_TIME_OUT         ((uint32_t)0x00005000)
+#define BLOCK_ERASE_TIME_OUT     ((uint32_t)0x00800000)
+
+
+/**
+ * @brief Wait for flash status flag clear.
+ *
+ * @param flag         Status flag to wait for.
+ * @param timeout      Max polling count.
+ *
+ * @return 0 : flag clear, 1 : timeout.
+ */
+static uint16_t flash_wait_clear(uint8_t flag, uint32_t timeout)
+{
+    while (FLASH->STATR & flag)
+    {
+        if (timeout-- == 0)
+            return 1;
+    }
+    return 0;
+}
 
 /**
  * @brief Flash lock.
@@ -57,24 +80,16 @@ void flash_unlock(void)
 uint16_t flash_program_256byte(uint32_t addr, uint32_t *buf)
 {
     uint8_t size = 64;
-    uint32_t timeout = 0;
 
-    if (addr & 0xFFFFFF00)
+    if (addr & (CHIP_FLASH_PAGE_SIZE - 1))
         return 1;
 
     __disable_irq();
     FLASH->CTLR |= FLASH_CTLR_PAGE_PG;
-    timeout = PROGRAM_TIME_OUT;
-    while ((FLASH->STATR & FLASH_STATR_BSY) && (timeout--));
-    if (timeout == 0)
-    {
-        __enable_irq();
-        return 1;
-    }    
-    timeout = PROGRAM_TIME_OUT;
-    while ((FLASH->STATR & FLASH_STATR_WR_BSY) && (timeout--));
-    if (timeout == 0)
+    if (flash_wait_clear(FLASH_STATR_BSY, PROGRAM_TIME_OUT)
+        || flash_wait_clear(FLASH_STATR_WR_BSY, PROGRAM_TIME_OUT))
     {
+        FLASH->CTLR &= ~FLASH_CTLR_PAGE_PG;
         __enable_irq();
         return 1;
     }
@@ -85,19 +100,18 @@ uint16_t flash_program_256byte(uint32_t addr, uint32_t *buf)
         addr += 4;
         buf += 1;
         size -= 1;
-        timeout = PROGRAM_TIME_OUT;
-        while ((FLASH->STATR & FLASH_STATR_WR_BSY) && (timeout--));
-        if (timeout == 0)
+        if (flash_wait_clear(FLASH_STATR_WR_BSY, PROGRAM_TIME_OUT))
         {
+            FLASH->CTLR &= ~FLASH_CTLR_PAGE_PG;
             __enable_irq();
             return 1;
         }   
     }
 
     FLASH->CTLR |= FLASH_CTLR_PG_STRT;
-    while ((FLASH->STATR & FLASH_STATR_BSY) && (timeout--));
-    if (timeout == 0)
+    if (flash_wait_clear(FLASH_STATR_BSY, ERASE_TIME_OUT))
     {
+        FLASH->CTLR &= ~FLASH_CTLR_PAGE_PG;
         __enable_irq();
         return 1;
     }
@@ -116,19 +130,16 @@ uint16_t flash_program_256byte(uint32_t addr, uint32_t *buf)
  */
 uint16_t flash_erase_256byte(uint32_t addr)
 {
-    uint32_t timeout = 0;
-    
-    if (addr & 0xFFFFFF00)
+    if (addr & (CHIP_FLASH_PAGE_SIZE - 1))
         return 1;
 
     __disable_irq();
     FLASH->CTLR |= FLASH_CTLR_PAGE_ER;
     FLASH->ADDR = addr;
     FLASH->CTLR |= FLASH_CTLR_STRT;
-    timeout = ERASE_TIME_OUT;
-    while ((FLASH->STATR & FLASH_STATR_BSY) && (timeout--));
-    if (timeout == 0)
+    if (flash_wait_clear(FLASH_STATR_BSY, ERASE_TIME_OUT))
     {
+        FLASH->CTLR &= ~FLASH_CTLR_PAGE_ER;
         __enable_irq();
         return 1;
     }
@@ -137,3 +148,43 @@ uint16_t flash_erase_256byte(uint32_t addr)
 
     return 0;
 }
+
+/**
+ * @brief Flash block erase, 4K sector or 32K/64K block.
+ *
+ * @param addr         Flash address to erase, aligned to the block size.
+ * @param size         Block size, CHIP_FLASH_SECTOR_SIZE, CHIP_FLASH_BLOCK32_SIZE or CHIP_FLASH_BLOCK64_SIZE.
+ *
+ * @return -1 : error.
+ */
+uint16_t flash_erase_block(uint32_t addr, uint32_t size)
+{
+    uint32_t mode;
+
+    if (size == CHIP_FLASH_SECTOR_SIZE)
+        mode = FLASH_CTLR_PER;
+    else if (size == CHIP_FLASH_BLOCK32_SIZE)
+        mode = FLASH_CTLR_PAGE_BER32;
+    else if (size == CHIP_FLASH_BLOCK64_SIZE)
+        mode = FLASH_CTLR_PAGE_BER64;
+    else
+        return 1;
+
+    if (addr & (size - 1))
+        return 1;
+
+    __disable_irq();
+    FLASH->CTLR |= mode;
+    FLASH->ADDR = addr;
+    FLASH->CTLR |= FLASH_CTLR_STRT;
+    if (flash_wait_clear(FLASH_STATR_BSY, BLOCK_ERASE_TIME_OUT))
+    {
+        FLASH->CTLR &= ~mode;
+        __enable_irq();
+        return 1;
+    }
+    FLASH->CTLR &= ~mode;
+    __enable_irq();
+
+    return 0;
+}
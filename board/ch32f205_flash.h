@@ -11,6 +11,7 @@ extern void flash_Lock(void);
 extern void flash_unlock(void);
 extern uint16_t flash_program_256byte(uint32_t addr, uint32_t *buf);
 extern uint16_t flash_erase_256byte(uint32_t addr);
+extern uint16_t flash_erase_block(uint32_t addr, uint32_t size);
 
 #ifdef __cplusplus
 }
@@ -15,6 +15,9 @@
 
 #define CHIP_APP_START                      (CONFIG_FLASH_START + CONFIG_BOOT_SIZE)
 #define CHIP_FLASH_PAGE_SIZE                (256)
+#define CHIP_FLASH_SECTOR_SIZE              (4 * 1024)
+#define CHIP_FLASH_BLOCK32_SIZE             (32 * 1024)
+#define CHIP_FLASH_BLOCK64_SIZE             (64 * 1024)
 #define CHIP_SRAM_END                       (CONFIG_RAM_START + CONFIG_RAM_SZIE)
 
 #endif
@@ -6,13 +6,45 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-12     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       add thread run time and stack statistics.
+ * 2026-10-18     SecondHandCoder       add tickless idle.
  */
 
 #include "ch32f205_rt_thread.h"
 #include "ch32f205_config.h"
 #include "rtthread.h"
+#include "rthw.h"
 #include "ch32f20x.h"
 #include "ch32f205_clk.h"
+#include "ch32f205_time.h"
+
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+
+/* thread statistics slot */
+typedef struct
+{
+    rt_thread_t thread;                         /* thread the slot belongs to, RT_NULL when free */
+    uint32_t switches;                          /* number of times the thread was switched in */
+    uint64_t cycles;                            /* cumulative DWT cycles the thread has run */
+} thread_stat_slot_t;
+
+/* thread statistics info */
+typedef struct
+{
+    uint32_t last_cycle;                        /* DWT cycle count at the last switch */
+    uint64_t uptime;                            /* cycles accounted since statistics start */
+    thread_stat_slot_t slot[THREAD_STAT_MAX];
+} thread_stat_info_t;
+
+static thread_stat_info_t thread_stat_info;
 
 
 /**
@@ -26,22 +58,274 @@ static void SystemClock_Config(void)
     NVIC_SetPriorityGrouping(5); // 2 - 2
 }
 
+static void thread_stat_charge(rt_thread_t thread);
+
 /**
  * @brief Systick interrupt handle, provide heartbeat ticks for the RTOS.
+ *        The running thread is charged every tick so the 32-bit cycle delta never wraps.
  *
  * @return None.
  */
 void SysTick_Handler(void)
 {
+    rt_base_t level;
+
     /* enter interrupt */
     rt_interrupt_enter();
 
+    level = rt_hw_interrupt_disable();
+    thread_stat_charge(rt_thread_self());
+    rt_hw_interrupt_enable(level);
+
     rt_tick_increase();
 
     /* leave interrupt */
     rt_interrupt_leave();
 }
 
+/**
+ * @brief Idle hook, stop the tick until the next timer deadline and sleep.
+ *        The skipped ticks are compensated on wake up, and DWT->CYCCNT is
+ *        corrected so it keeps counting wall time across the sleep.
+ *
+ * @return None.
+ */
+void dap_tickless_idle(void)
+{
+    uint32_t cycles_per_tick = SystemCoreClock / RT_TICK_PER_SECOND;
+    uint32_t ticks, cur, reload, start, slept, total, add, next;
+    rt_tick_t timeout;
+    rt_base_t level;
+    bool expired;
+
+    level = rt_hw_interrupt_disable();
+
+    timeout = rt_timer_next_timeout_tick();
+    if (timeout == RT_TICK_MAX)
+        ticks = TICKLESS_MAX_TICKS;
+    else if ((rt_int32_t)(timeout - rt_tick_get()) < 1)
+        ticks = 1;
+    else
+        ticks = MIN(timeout - rt_tick_get(), TICKLESS_MAX_TICKS);
+    ticks = MIN(ticks, 0xFFFFFFU / cycles_per_tick);
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    cur = SysTick->VAL;
+    // a tick is pending or about to be, let it run
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || (cur < TICKLESS_MIN_CYCLES))
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+
+    reload = cur + (ticks - 1) * cycles_per_tick;
+    start = DWT->CYCCNT;
+    SysTick->LOAD = reload;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    __DSB();
+    __WFI();
+    __ISB();
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    // reading CTRL clears COUNTFLAG, the pending exception tells the sleep ran out
+    expired = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+    slept = reload - SysTick->VAL;
+    if (expired)
+        slept += reload + 1;
+
+    // cycles since the tick boundary before sleep
+    total = cycles_per_tick - cur + slept;
+    add = total / cycles_per_tick;
+    // the pending SysTick handler accounts the last tick
+    if (expired)
+        add--;
+
+    next = cycles_per_tick - (total % cycles_per_tick);
+    SysTick->LOAD = MAX(next, 2U) - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = cycles_per_tick - 1;
+
+    rt_tick_set(rt_tick_get() + add);
+    DWT->CYCCNT = start + slept;
+
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief Find the statistics slot of a thread, allocate one if not exist.
+ *
+ * @param thread        A pointer to the thread.
+ *
+ * @return The slot of the thread, RT_NULL if the table is full.
+ */
+static thread_stat_slot_t *thread_stat_slot(rt_thread_t thread)
+{
+    thread_stat_slot_t *free_slot = RT_NULL;
+
+    for (uint32_t i = 0; i < THREAD_STAT_MAX; i++)
+    {
+        if (thread_stat_info.slot[i].thread == thread)
+            return &thread_stat_info.slot[i];
+        if ((free_slot == RT_NULL) && (thread_stat_info.slot[i].thread == RT_NULL))
+            free_slot = &thread_stat_info.slot[i];
+    }
+    if (free_slot != RT_NULL)
+    {
+        free_slot->thread = thread;
+        free_slot->switches = 0;
+        free_slot->cycles = 0;
+    }
+
+    return free_slot;
+}
+
+/**
+ * @brief Charge the cycles since the last switch to a thread, called with interrupt disabled.
+ *
+ * @param thread        A pointer to the thread which has been running.
+ *
+ * @return None.
+ */
+static void thread_stat_charge(rt_thread_t thread)
+{
+    thread_stat_slot_t *slot;
+    uint32_t now = DWT->CYCCNT;
+    uint32_t delta = now - thread_stat_info.last_cycle;
+
+    thread_stat_info.last_cycle = now;
+    thread_stat_info.uptime += delta;
+    // no thread runs before the scheduler starts
+    if ((thread != RT_NULL) && ((slot = thread_stat_slot(thread)) != RT_NULL))
+        slot->cycles += delta;
+}
+
+/**
+ * @brief Scheduler hook, account run cycles and switch count.
+ *
+ * @param from          The thread switched out.
+ * @param to            The thread switched in.
+ *
+ * @return None.
+ */
+static void thread_stat_scheduler_hook(struct rt_thread *from, struct rt_thread *to)
+{
+    thread_stat_slot_t *slot;
+
+    thread_stat_charge(from);
+    if ((slot = thread_stat_slot(to)) != RT_NULL)
+        slot->switches++;
+}
+
+/**
+ * @brief Object detach hook, release the slot of a deleted thread.
+ *
+ * @param object        The object being detached or deleted.
+ *
+ * @return None.
+ */
+static void thread_stat_detach_hook(struct rt_object *object)
+{
+    if ((object->type & ~RT_Object_Class_Static) != RT_Object_Class_Thread)
+        return;
+
+    rt_base_t level = rt_hw_interrupt_disable();
+    for (uint32_t i = 0; i < THREAD_STAT_MAX; i++)
+    {
+        if (thread_stat_info.slot[i].thread == (rt_thread_t)object)
+            thread_stat_info.slot[i].thread = RT_NULL;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief Get the max stack usage of a thread by the untouched '#' fill pattern.
+ *
+ * @param thread        A pointer to the thread.
+ *
+ * @return Max stack usage in bytes.
+ */
+static uint32_t thread_stat_stack_used(rt_thread_t thread)
+{
+    uint8_t *ptr = (uint8_t *)thread->stack_addr;
+    uint32_t unused = 0;
+
+    while ((unused < thread->stack_size) && (*ptr++ == '#'))
+        unused++;
+
+    return thread->stack_size - unused;
+}
+
+/**
+ * @brief Thread statistics init, install scheduler and object hooks.
+ *
+ * @return None.
+ */
+void dap_thread_stat_init(void)
+{
+    rt_memset(&thread_stat_info, 0, sizeof(thread_stat_info));
+    thread_stat_info.last_cycle = DWT->CYCCNT;
+    rt_object_detach_sethook(thread_stat_detach_hook);
+    rt_scheduler_sethook(thread_stat_scheduler_hook);
+}
+
+/**
+ * @brief Get the statistics of the living threads.
+ *
+ * @param stat          A pointer to the statistics buffer.
+ * @param start         Index of the first thread to report.
+ * @param max           Max number of threads to report.
+ * @param uptime        A pointer to the cycles accounted since statistics start.
+ *
+ * @return Total number of living threads.
+ */
+uint32_t dap_thread_stat_get(dap_thread_stat_t *stat, uint32_t start, uint32_t max, uint64_t *uptime)
+{
+    struct rt_object_information *info = rt_object_get_information(RT_Object_Class_Thread);
+    struct rt_list_node *node;
+    uint32_t index = 0, cnt = 0;
+    rt_base_t level;
+
+    rt_enter_critical();
+    level = rt_hw_interrupt_disable();
+    thread_stat_charge(rt_thread_self());
+    *uptime = thread_stat_info.uptime;
+    rt_hw_interrupt_enable(level);
+
+    for (node = info->object_list.next; node != &info->object_list; node = node->next, index++)
+    {
+        rt_thread_t thread = (rt_thread_t)rt_list_entry(node, struct rt_object, list);
+        thread_stat_slot_t *slot;
+
+        if ((index < start) || (cnt >= max))
+            continue;
+
+        rt_strncpy(stat[cnt].name, thread->parent.name, RT_NAME_MAX);
+        stat[cnt].priority = thread->current_priority;
+        stat[cnt].stack_size = thread->stack_size;
+        stat[cnt].stack_used = thread_stat_stack_used(thread);
+        level = rt_hw_interrupt_disable();
+        if ((slot = thread_stat_slot(thread)) != RT_NULL)
+        {
+            stat[cnt].switches = slot->switches;
+            stat[cnt].cycles = slot->cycles;
+        }
+        else
+        {
+            stat[cnt].switches = 0;
+            stat[cnt].cycles = 0;
+        }
+        rt_hw_interrupt_enable(level);
+        cnt++;
+    }
+    rt_exit_critical();
+
+    return index;
+}
+
 /**
  * @brief Board init, clock config, heap config, components init.
  *
@@ -52,6 +336,10 @@ void rt_hw_board_init(void)
     /* System clock initialization */
     SystemClock_Config();
 
+    /* Thread statistics initialization, on a running cycle counter */
+    dap_timestamp_init();
+    dap_thread_stat_init();
+
     /* Heap initialization */
 #if defined(RT_USING_HEAP)
     rt_system_heap_init((void *)HEAP_BEGIN, (void *)HEAP_END);
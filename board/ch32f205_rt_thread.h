@@ -1,11 +1,37 @@
 #ifndef __CH32F205_RT_THREAD_H__
 #define __CH32F205_RT_THREAD_H__
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "rtthread.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// max ticks skipped by the tickless idle
+#define TICKLESS_MAX_TICKS              100U
+// min cycles left in the tick period to enter sleep
+#define TICKLESS_MIN_CYCLES             1000U
+
+// max threads tracked by the statistics
+#define THREAD_STAT_MAX                 12U
+
+/* thread statistics */
+typedef struct
+{
+    char name[RT_NAME_MAX];                     /* thread name */
+    uint8_t priority;                           /* thread current priority */
+    uint32_t stack_size;                        /* stack size in bytes */
+    uint32_t stack_used;                        /* max stack usage in bytes */
+    uint32_t switches;                          /* number of times the thread was switched in */
+    uint64_t cycles;                            /* cumulative DWT cycles the thread has run */
+} dap_thread_stat_t;
+
 extern void rt_hw_board_init(void);
+extern void dap_tickless_idle(void);
+extern void dap_thread_stat_init(void);
+extern uint32_t dap_thread_stat_get(dap_thread_stat_t *stat, uint32_t start, uint32_t max, uint64_t *uptime);
 
 #ifdef __cplusplus
 }
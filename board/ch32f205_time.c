@@ -6,10 +6,22 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-22     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       add high resolution timer service.
  */
 
 #include "ch32f205_time.h"
 #include "ch32f205_clk.h"
+#include "rthw.h"
+
+
+/* high resolution timer service info */
+typedef struct
+{
+    dap_hrtimer_t *head;                        /* pending timers sorted by deadline */
+    uint32_t ticks_per_us;                      /* DWT cycles per microsecond */
+} hrtimer_info_t;
+
+static hrtimer_info_t hrtimer_info;
 
 /**
  * @brief DAP timestamp(DWT) init.
@@ -18,6 +30,10 @@
  */
 void dap_timestamp_init(void)
 {
+    // started by the board init for the thread statistics, keep the count running
+    if (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)
+        return;
+
     DWT->CTRL &= ~DWT_CTRL_CYCCNTENA_Msk;
     DWT->CYCCNT = 0;
     CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
@@ -70,3 +86,232 @@ bool dap_wait_us_noblock(uint32_t pre_ticks, uint32_t us)
     else
         return ((0xFFFFFFFF - pre_ticks + now) > ticks);
 }
+
+/**
+ * @brief Program the hardware timer for the earliest pending deadline, called with interrupt disabled.
+ *
+ * @return None.
+ */
+static void hrtimer_arm(void)
+{
+    int32_t remain;
+    uint32_t us;
+
+    HRTIMER_TIM->CTLR1 &= ~TIM_CEN;
+    HRTIMER_TIM->INTFR = (uint16_t)~TIM_UIF;
+    if (hrtimer_info.head == NULL)
+        return;
+
+    remain = (int32_t)(hrtimer_info.head->deadline - DWT->CYCCNT);
+    us = (remain <= 0) ? 0 : ((uint32_t)remain + hrtimer_info.ticks_per_us - 1) / hrtimer_info.ticks_per_us;
+    // counter blocks when reload is 0, update fires after reload + 1 counts
+    if (us < 2)
+        us = 2;
+    if (us > 0xFFFF)
+        us = 0xFFFF;
+
+    HRTIMER_TIM->ATRLR = us - 1;
+    HRTIMER_TIM->CNT = 0;
+    HRTIMER_TIM->CTLR1 = TIM_OPM | TIM_URS | TIM_CEN;
+}
+
+/**
+ * @brief Insert a timer into the pending list, called with interrupt disabled.
+ *
+ * @param timer         A pointer to the timer.
+ *
+ * @return None.
+ */
+static void hrtimer_insert(dap_hrtimer_t *timer)
+{
+    dap_hrtimer_t **node = &hrtimer_info.head;
+
+    while ((*node != NULL) && ((int32_t)((*node)->deadline - timer->deadline) <= 0))
+        node = &(*node)->next;
+    timer->next = *node;
+    *node = timer;
+    timer->active = 1;
+}
+
+/**
+ * @brief Remove a timer from the pending list, called with interrupt disabled.
+ *
+ * @param timer         A pointer to the timer.
+ *
+ * @return None.
+ */
+static void hrtimer_remove(dap_hrtimer_t *timer)
+{
+    dap_hrtimer_t **node = &hrtimer_info.head;
+
+    while (*node != NULL)
+    {
+        if (*node == timer)
+        {
+            *node = timer->next;
+            break;
+        }
+        node = &(*node)->next;
+    }
+    timer->next = NULL;
+    timer->active = 0;
+}
+
+/**
+ * @brief High resolution timer interrupt handle, run the expired timers.
+ *
+ * @return None.
+ */
+void HRTIMER_IRQ_HANDLE(void)
+{
+    dap_hrtimer_t *timer;
+
+    rt_interrupt_enter();
+    if (HRTIMER_TIM->INTFR & TIM_UIF)
+    {
+        rt_base_t level = rt_hw_interrupt_disable();
+
+        while (((timer = hrtimer_info.head) != NULL) && ((int32_t)(timer->deadline - DWT->CYCCNT) <= 0))
+        {
+            hrtimer_remove(timer);
+            if (timer->period)
+            {
+                timer->deadline += timer->period;
+                // fell behind, restart the period from now
+                if ((int32_t)(timer->deadline - DWT->CYCCNT) <= 0)
+                    timer->deadline = DWT->CYCCNT + timer->period;
+                hrtimer_insert(timer);
+            }
+            rt_hw_interrupt_enable(level);
+            timer->timeout(timer->parameter);
+            level = rt_hw_interrupt_disable();
+        }
+        hrtimer_arm();
+        rt_hw_interrupt_enable(level);
+    }
+    rt_interrupt_leave();
+}
+
+/**
+ * @brief High resolution timer service init, the hardware timer counts in microsecond.
+ *
+ * @return None.
+ */
+void dap_hrtimer_service_init(void)
+{
+    hrtimer_info.head = NULL;
+    hrtimer_info.ticks_per_us = SystemCoreClock / 1000000;
+
+    HRTIMER_RCC_EN();
+    HRTIMER_TIM->CTLR1 = TIM_URS;
+    // APB1 runs at HCLK / 2, the timer clock is doubled to HCLK
+    HRTIMER_TIM->PSC = hrtimer_info.ticks_per_us - 1;
+    HRTIMER_TIM->SWEVGR = TIM_UG;
+    HRTIMER_TIM->INTFR = (uint16_t)~TIM_UIF;
+    HRTIMER_TIM->DMAINTENR = TIM_UIE;
+
+    NVIC_SetPriority(HRTIMER_IRQ_VECTOR, 4);
+    NVIC_EnableIRQ(HRTIMER_IRQ_VECTOR);
+}
+
+/**
+ * @brief High resolution timer init.
+ *
+ * @param timer         A pointer to the timer.
+ * @param timeout       Timeout callback, called in interrupt context.
+ * @param parameter     Timeout callback parameter.
+ *
+ * @return None.
+ */
+void dap_hrtimer_init(dap_hrtimer_t *timer, void (*timeout)(void *parameter), void *parameter)
+{
+    timer->next = NULL;
+    timer->timeout = timeout;
+    timer->parameter = parameter;
+    timer->deadline = 0;
+    timer->period = 0;
+    timer->active = 0;
+}
+
+/**
+ * @brief Start or restart a high resolution timer.
+ *
+ * @param timer         A pointer to the timer.
+ * @param us            Timeout unit microsecond, max HRTIMER_MAX_US.
+ * @param period_us     Reload period unit microsecond, 0 for one-shot.
+ *
+ * @return None.
+ */
+void dap_hrtimer_start(dap_hrtimer_t *timer, uint32_t us, uint32_t period_us)
+{
+    rt_base_t level;
+
+    if (us > HRTIMER_MAX_US)
+        us = HRTIMER_MAX_US;
+    if (period_us > HRTIMER_MAX_US)
+        period_us = HRTIMER_MAX_US;
+
+    level = rt_hw_interrupt_disable();
+    if (timer->active)
+        hrtimer_remove(timer);
+    timer->deadline = DWT->CYCCNT + us * hrtimer_info.ticks_per_us;
+    timer->period = period_us * hrtimer_info.ticks_per_us;
+    hrtimer_insert(timer);
+    if (hrtimer_info.head == timer)
+        hrtimer_arm();
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief Stop a high resolution timer.
+ *
+ * @param timer         A pointer to the timer.
+ *
+ * @return None.
+ */
+void dap_hrtimer_stop(dap_hrtimer_t *timer)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    if (timer->active)
+    {
+        dap_hrtimer_t *head = hrtimer_info.head;
+
+        hrtimer_remove(timer);
+        if (head == timer)
+            hrtimer_arm();
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * @brief Sleep timeout callback, wake the sleeping thread.
+ *
+ * @param parameter     A pointer to the semaphore the thread waits on.
+ *
+ * @return None.
+ */
+static void hrtimer_sleep_timeout(void *parameter)
+{
+    rt_sem_release((rt_sem_t)parameter);
+}
+
+/**
+ * @brief Block the calling thread for a microsecond delay, other threads run meanwhile.
+ *        Unlike rt_thread_mdelay the wake up is not rounded to the next tick.
+ *
+ * @param us            Time delay unit microsecond, max HRTIMER_MAX_US.
+ *
+ * @return None.
+ */
+void dap_hrtimer_sleep(uint32_t us)
+{
+    struct rt_semaphore sem;
+    dap_hrtimer_t timer;
+
+    rt_sem_init(&sem, "hrsleep", 0, RT_IPC_FLAG_FIFO);
+    dap_hrtimer_init(&timer, hrtimer_sleep_timeout, &sem);
+    dap_hrtimer_start(&timer, us, 0);
+    rt_sem_take(&sem, RT_WAITING_FOREVER);
+    rt_sem_detach(&sem);
+}
@@ -8,6 +8,27 @@
 extern "C" {
 #endif
 
+// HIGH RESOLUTION TIMER
+#define HRTIMER_TIM                                         TIM6
+#define HRTIMER_IRQ_VECTOR                                  TIM6_IRQn
+#define HRTIMER_IRQ_HANDLE                                  TIM6_IRQHandler
+#define HRTIMER_RCC_EN()                                    (RCC->APB1PCENR |= 0x00000010)
+// max timeout, keep the DWT deadline compare in the signed range
+#define HRTIMER_MAX_US                                      10000000U
+// shorter waits spin, a thread switch costs more than the sleep saves
+#define HRTIMER_SLEEP_MIN_US                                1000U
+
+/* high resolution one-shot/periodic timer */
+typedef struct dap_hrtimer
+{
+    struct dap_hrtimer *next;                   /* next pending timer, sorted by deadline */
+    void (*timeout)(void *parameter);           /* timeout callback, called in interrupt context */
+    void *parameter;                            /* timeout callback parameter */
+    uint32_t deadline;                          /* DWT cycle count of the deadline */
+    uint32_t period;                            /* reload period in DWT cycles, 0 for one-shot */
+    uint8_t active;                             /* timer is pending */
+} dap_hrtimer_t;
+
 // TIME STAMP
 __STATIC_FORCEINLINE uint32_t dap_get_cur_tick(void)
 {
@@ -17,6 +38,11 @@ __STATIC_FORCEINLINE uint32_t dap_get_cur_tick(void)
 extern void dap_timestamp_init(void);
 extern void rt_hw_us_delay(rt_uint32_t us);
 extern bool dap_wait_us_noblock(uint32_t pre_ticks, uint32_t us);
+extern void dap_hrtimer_service_init(void);
+extern void dap_hrtimer_init(dap_hrtimer_t *timer, void (*timeout)(void *parameter), void *parameter);
+extern void dap_hrtimer_start(dap_hrtimer_t *timer, uint32_t us, uint32_t period_us);
+extern void dap_hrtimer_stop(dap_hrtimer_t *timer);
+extern void dap_hrtimer_sleep(uint32_t us);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2006-2023, SecondHandCoder
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author                Notes
+ * 2026-10-18     SecondHandCoder       first version.
+ */
+
+#include "boot_lz.h"
+
+
+#define LZ_WINDOW_MASK                  (LZ_WINDOW_SIZE - 1U)
+
+#define LZ_STATE_ITEM                   0U
+#define LZ_STATE_MATCH_LO               1U
+#define LZ_STATE_MATCH_HI               2U
+
+
+/**
+ * @brief LZ decoder init, call before every new stream.
+ *
+ * @param dec           A pointer to the decoder.
+ *
+ * @return None.
+ */
+void lz_decoder_init(lz_decoder_t *dec)
+{
+    dec->window_pos = 0;
+    dec->match_dist = 0;
+    dec->match_len = 0;
+    dec->match_lo = 0;
+    dec->flags = 0;
+    dec->flag_bits = 0;
+    dec->state = LZ_STATE_ITEM;
+}
+
+/**
+ * @brief LZ streaming decode, stops when the input is used up or the output is full,
+ *        the next call continues where this one stopped.
+ *
+ * @param dec           A pointer to the decoder.
+ * @param in            A pointer to the compressed data.
+ * @param in_len        Len of the compressed data, returns the len consumed.
+ * @param out           A pointer to the output buffer.
+ * @param out_len       Len of the output buffer.
+ *
+ * @return Len of the decoded data.
+ */
+uint32_t lz_decode(lz_decoder_t *dec, const uint8_t *in, uint32_t *in_len, uint8_t *out, uint32_t out_len)
+{
+    uint32_t in_ptr = 0, out_ptr = 0;
+    uint8_t byte;
+
+    while (1)
+    {
+        /* copy the pending match */
+        if (dec->match_len)
+        {
+            if (out_ptr == out_len)
+                break;
+            byte = dec->window[(dec->window_pos - dec->match_dist) & LZ_WINDOW_MASK];
+            dec->window[dec->window_pos] = byte;
+            dec->window_pos = (dec->window_pos + 1) & LZ_WINDOW_MASK;
+            out[out_ptr++] = byte;
+            dec->match_len--;
+            continue;
+        }
+
+        if (dec->state == LZ_STATE_MATCH_LO)
+        {
+            if (in_ptr == *in_len)
+                break;
+            dec->match_lo = in[in_ptr++];
+            dec->state = LZ_STATE_MATCH_HI;
+            continue;
+        }
+
+        if (dec->state == LZ_STATE_MATCH_HI)
+        {
+            if (in_ptr == *in_len)
+                break;
+            byte = in[in_ptr++];
+            dec->match_dist = (((uint16_t)(byte >> 6) << 8) | dec->match_lo) + 1;
+            dec->match_len = (byte & 0x3F) + LZ_MIN_MATCH;
+            dec->state = LZ_STATE_ITEM;
+            continue;
+        }
+
+        /* next item, load a new flag byte every 8 items */
+        if (dec->flag_bits == 0)
+        {
+            if (in_ptr == *in_len)
+                break;
+            dec->flags = in[in_ptr++];
+            dec->flag_bits = 8;
+            continue;
+        }
+
+        if (dec->flags & 0x01)
+        {
+            if ((in_ptr == *in_len) || (out_ptr == out_len))
+                break;
+            byte = in[in_ptr++];
+            dec->window[dec->window_pos] = byte;
+            dec->window_pos = (dec->window_pos + 1) & LZ_WINDOW_MASK;
+            out[out_ptr++] = byte;
+        }
+        else
+        {
+            dec->state = LZ_STATE_MATCH_LO;
+        }
+        dec->flags >>= 1;
+        dec->flag_bits--;
+    }
+
+    *in_len = in_ptr;
+    return out_ptr;
+}
+
+#ifdef LZ_ENCODER
+/**
+ * @brief LZ encode, used by the host tool.
+ *
+ * @param in            A pointer to the raw data.
+ * @param in_len        Len of the raw data.
+ * @param out           A pointer to the output buffer.
+ * @param out_size      Size of the output buffer, LZ_ENCODE_BOUND(in_len) is always enough.
+ *
+ * @return Len of the compressed data, 0 if the output buffer is too small.
+ */
+uint32_t lz_encode(const uint8_t *in, uint32_t in_len, uint8_t *out, uint32_t out_size)
+{
+    uint32_t in_ptr = 0, out_ptr = 0, flag_ptr = 0;
+    uint8_t flag_bits = 8;
+
+    while (in_ptr < in_len)
+    {
+        uint32_t best_len = 0, best_dist = 0;
+        uint32_t max_len = in_len - in_ptr;
+        uint32_t start = (in_ptr > LZ_WINDOW_SIZE) ? (in_ptr - LZ_WINDOW_SIZE) : 0;
+
+        if (max_len > LZ_MAX_MATCH)
+            max_len = LZ_MAX_MATCH;
+
+        /* nearest longest match, overlapping the current position is allowed */
+        for (uint32_t pos = in_ptr; pos-- > start;)
+        {
+            uint32_t len = 0;
+
+            while ((len < max_len) && (in[pos + len] == in[in_ptr + len]))
+                len++;
+            if (len > best_len)
+            {
+                best_len = len;
+                best_dist = in_ptr - pos;
+                if (len == max_len)
+                    break;
+            }
+        }
+
+        if (flag_bits == 8)
+        {
+            if (out_ptr >= out_size)
+                return 0;
+            flag_ptr = out_ptr++;
+            out[flag_ptr] = 0;
+            flag_bits = 0;
+        }
+
+        if (best_len >= LZ_MIN_MATCH)
+        {
+            if ((out_ptr + 2) > out_size)
+                return 0;
+            out[out_ptr++] = (uint8_t)(best_dist - 1);
+            out[out_ptr++] = (uint8_t)((((best_dist - 1) >> 8) << 6) | (best_len - LZ_MIN_MATCH));
+            in_ptr += best_len;
+        }
+        else
+        {
+            if (out_ptr >= out_size)
+                return 0;
+            out[flag_ptr] |= (uint8_t)(1U << flag_bits);
+            out[out_ptr++] = in[in_ptr++];
+        }
+        flag_bits++;
+    }
+
+    return out_ptr;
+}
+#endif
@@ -0,0 +1,42 @@
+#ifndef __BOOT_LZ_H__
+#define __BOOT_LZ_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LZ stream: a flag byte precedes every 8 items, flag bit 1 is a literal byte,
+// flag bit 0 is a 2 byte match, (dist - 1)[7:0], (dist - 1)[9:8] << 6 | (len - LZ_MIN_MATCH)
+#define LZ_WINDOW_SIZE                  1024U
+#define LZ_MIN_MATCH                    3U
+#define LZ_MAX_MATCH                    (LZ_MIN_MATCH + 0x3FU)
+
+/* LZ streaming decoder state */
+typedef struct
+{
+    uint8_t window[LZ_WINDOW_SIZE];             /* history of the decoded data */
+    uint16_t window_pos;                        /* next write position in the history */
+    uint16_t match_dist;                        /* distance of the match being copied */
+    uint8_t match_len;                          /* bytes left of the match being copied */
+    uint8_t match_lo;                           /* first byte of a match split across input */
+    uint8_t flags;                              /* current flag byte, shifted as items are decoded */
+    uint8_t flag_bits;                          /* items left in the current flag byte */
+    uint8_t state;                              /* decoder state */
+} lz_decoder_t;
+
+extern void lz_decoder_init(lz_decoder_t *dec);
+extern uint32_t lz_decode(lz_decoder_t *dec, const uint8_t *in, uint32_t *in_len, uint8_t *out, uint32_t out_len);
+
+#ifdef LZ_ENCODER
+#define LZ_ENCODE_BOUND(len)            ((len) + ((len) + 7U) / 8U)
+
+extern uint32_t lz_encode(const uint8_t *in, uint32_t in_len, uint8_t *out, uint32_t out_size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
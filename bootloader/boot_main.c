@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-22     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       enable the update path.
  */
 
 #include "ch32f205_config.h"
@@ -34,25 +35,25 @@ uint32_t *const VectorTable[] __USED __VECTOR_TABLE_ATTRIBUTE =
  */
 void Reset_Handler(void)
 {
-	/* TODO App write update flag or app vector is empty, run boot process */
-	//if ((get_backup_data() == BACK_UP_DATA) || ((*(__IO uint32_t *)CHIP_APP_START) != CHIP_SRAM_END))
-    //{
-	//	__disable_irq();
-	//	SystemInit();
-	//	init_data_bss();
-	//	usb_interface_init();
-	//	__enable_irq();
-	//	while (1)
-	//	{
-	//		if (boot_update_main() == BOOT_END)
-	//		{
-	//			set_backup_data(0);
-	//			break;
-	//		}	
-	//	};
-	//	__disable_irq();
-	//	NVIC_SystemReset();
-	//}
+	/* App write update flag or app vector is empty, run boot process */
+	if ((get_backup_data() == BACK_UP_DATA) || ((*(__IO uint32_t *)CHIP_APP_START) != CHIP_SRAM_END))
+    {
+		__disable_irq();
+		SystemInit();
+		init_data_bss();
+		usb_interface_init();
+		__enable_irq();
+		while (1)
+		{
+			if (boot_update_main() == BOOT_END)
+			{
+				set_backup_data(0);
+				break;
+			}	
+		};
+		__disable_irq();
+		NVIC_SystemReset();
+	}
 	__disable_irq();
 	funct_ptr app_ptr = (funct_ptr) *(__IO uint32_t *)(CHIP_APP_START + 0x04);
 	SCB->VTOR = CHIP_APP_START;
@@ -6,6 +6,9 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-22     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       double buffered page writes and batched acks.
+ * 2026-10-18     SecondHandCoder       block erase and skip unchanged pages.
+ * 2026-10-18     SecondHandCoder       compressed firmware data.
  */
 
 #include "usb_main.h"
@@ -13,6 +16,7 @@
 #include "usb_descriptor.h"
 #include "ch32f205_crc.h"
 #include "ch32f205_flash.h"
+#include "boot_lz.h"
 
 
 #define BOOT_USB_WAIT_FOREVER                                           (-1)
@@ -24,16 +28,28 @@
 #define BOOT_CMD_REVE_PAGE_SIZE                                         (0x11)
 #define BOOT_CMD_FIRMWARE_DATA                                          (0x21)
 #define BOOT_CMD_FIRMWARE_DATA_REPLY                                    (0x20)
+#define BOOT_CMD_FIRMWARE_LZ_DATA                                       (0x22)
 #define BOOT_CMD_CRC_SEND                                               (0x30)
 
+/* Page buffers, one is filled by USB while the other is programmed */
+#define BOOT_PAGE_BUFFER_NUM                                            (2)
+/* Max pages acked by one reply */
+#define BOOT_ACK_WINDOW_MAX                                             (32)
+/* Consecutive changed pages before switching to block erase */
+#define BOOT_DENSE_PAGE_NUM                                             (16)
+/* Pages of the APP region */
+#define BOOT_APP_PAGE_NUM                                               ((CONFIG_FLASH_SIZE - CONFIG_BOOT_SIZE) / CHIP_FLASH_PAGE_SIZE)
+
 /* FLASH write data info */
 typedef struct
 {
+    uint32_t page_cur_buffer[CHIP_FLASH_PAGE_SIZE / 4];                 /* FLASH current write buffer*/
     uint16_t page_cur_page;                                             /* FLASH current write page */
-    uint16_t page_cur_index;                                            /* FLASH current write page data package index */                           
+    uint16_t page_cur_index;                                            /* FLASH current write page data package index */
     uint16_t page_cur_point;                                            /* FLASH current write buffer point */
-    uint8_t page_cur_buffer[CHIP_FLASH_PAGE_SIZE];                      /* FLASH current write buffer*/
-} __PACKED flash_write_info_t;
+    uint16_t page_last_length;                                          /* Data length of the last page data package */
+    uint8_t page_reply;                                                 /* Page completion is replied in lockstep, 0 : acked per compressed package */
+} flash_write_info_t;
 
 /* Transmission message info */
 typedef struct
@@ -65,10 +81,45 @@ typedef struct
     uint8_t message_data[DAP_PACKET_SIZE - sizeof(message_header_t)];   /* Transmission data */
 } __PACKED message_packert_t;
 
+/* FLASH write pipeline info */
+typedef struct
+{
+    volatile uint8_t fill;                                              /* Page buffer filled by USB */
+    volatile uint8_t program;                                           /* Page buffer to be programmed next */
+    volatile uint8_t ready;                                             /* Number of full page buffers waiting for program */
+    volatile uint8_t out_pending;                                       /* USB OUT is not armed, waiting for a free page buffer */
+    volatile uint8_t crc_pending;                                       /* CRC verification waiting for programming done */
+    volatile uint8_t reply_pending;                                     /* Reply header waiting for sending */
+    message_header_t reply_header;                                      /* Reply header */
+    uint16_t ack_window;                                                /* Pages acked by one reply, 0 : reply every data package */
+    uint16_t unacked;                                                   /* Pages programmed and not acked */
+    uint16_t ack_page;                                                  /* Page num of the last programmed page */
+    uint16_t ack_index;                                                 /* Last data package index of the last programmed page */
+    uint16_t ack_length;                                                /* Last data package length of the last programmed page */
+    uint16_t image_pages;                                               /* Pages of the incoming image, 0 : unknown */
+    uint16_t changed_run;                                               /* Consecutive pages differing from FLASH */
+    uint16_t pages_written;                                             /* Pages erased and programmed */
+    uint16_t pages_skipped;                                             /* Pages identical to FLASH, not programmed */
+    volatile uint8_t lz_pending;                                        /* Compressed package waiting for decoding, USB OUT is not armed */
+    uint16_t lz_index;                                                  /* Compressed package index */
+    uint16_t lz_page;                                                   /* Page num of the next decoded page */
+    uint16_t lz_length;                                                 /* Compressed data length of the current package */
+    uint16_t lz_consumed;                                               /* Compressed data decoded of the current package */
+} flash_pipeline_t;
+
+/* Update progress, appended to replies when an ack window is used */
+typedef struct
+{
+    uint16_t pages_written;                                             /* Pages erased and programmed */
+    uint16_t pages_skipped;                                             /* Pages identical to FLASH, not programmed */
+} __PACKED boot_progress_t;
+
 static uint8_t usb_is_ok = false;
 static int32_t usb_wait_cnt = 0;
 static boot_main_state_t boot_main_state;
-static flash_write_info_t flash_write_info;
+static flash_write_info_t flash_write_info[BOOT_PAGE_BUFFER_NUM];
+static flash_pipeline_t flash_pipeline;
+static lz_decoder_t lz_decoder;
 static USB_MEM_ALIGNX message_packert_t rece_message_packert;
 static USB_MEM_ALIGNX message_packert_t send_message_packert;
 struct usbd_interface dap_intf;
@@ -90,92 +141,273 @@ static struct usbd_endpoint boot_in_ep =
 
 
 /**
- * @brief USB boot has data requests.
+ * @brief Queue a firmware data reply, a newer reply replaces the pending one,
+ *        except that a pending error is never replaced by an ack so the host
+ *        always gets the retransmit request.
+ *
+ * @param bits          Reply status bits.
+ * @param value         Page num.
+ * @param index         Page package index, or pages acked by a batched reply.
+ * @param length        Data length.
+ *
+ * @return 1 : queued, 0 : an error reply is pending.
+ */
+static uint8_t boot_reply_queue(uint8_t bits, uint16_t value, uint16_t index, uint16_t length)
+{
+    message_header_t ack = {0};
+
+    ack.request.bits.ack = 1;
+    if ((flash_pipeline.reply_pending) && (bits == ack.request.byte)
+        && (flash_pipeline.reply_header.request.byte != ack.request.byte))
+        return 0;
+
+    flash_pipeline.reply_header.type = BOOT_CMD_FIRMWARE_DATA_REPLY;
+    flash_pipeline.reply_header.request.byte = bits;
+    flash_pipeline.reply_header.value = value;
+    flash_pipeline.reply_header.index = index;
+    flash_pipeline.reply_header.length = length;
+    flash_pipeline.reply_pending = 1;
+    return 1;
+}
+
+/**
+ * @brief Ack the programmed pages when the window is full, or when the pipeline is
+ *        drained so the host never stalls. Lockstep replies keep the page package
+ *        index and length of the last package, a batched reply carries the page count.
+ *        Called with interrupts disabled.
+ *
+ * @return None.
+ */
+static void boot_ack_pages(void)
+{
+    message_header_t reply = {0};
+    uint8_t queued;
+
+    if ((flash_pipeline.unacked == 0)
+        || ((flash_pipeline.unacked < flash_pipeline.ack_window) && (flash_pipeline.ready != 0)))
+        return;
+
+    reply.request.bits.ack = 1;
+    if (flash_pipeline.ack_window == 0)
+        queued = boot_reply_queue(reply.request.byte, flash_pipeline.ack_page, flash_pipeline.ack_index, flash_pipeline.ack_length);
+    else
+        queued = boot_reply_queue(reply.request.byte, flash_pipeline.ack_page, flash_pipeline.unacked, 0);
+    if (queued)
+        flash_pipeline.unacked = 0;
+}
+
+/**
+ * @brief Append the update progress to the send message when an ack window is used.
+ *
+ * @return Len of the send message.
+ */
+static uint16_t boot_progress_append(void)
+{
+    boot_progress_t progress;
+
+    if (flash_pipeline.ack_window == 0)
+        return sizeof(message_header_t);
+
+    progress.pages_written = flash_pipeline.pages_written;
+    progress.pages_skipped = flash_pipeline.pages_skipped;
+    memcpy(send_message_packert.message_data, &progress, sizeof(boot_progress_t));
+    send_message_packert.message_header.length = sizeof(boot_progress_t);
+
+    return sizeof(message_header_t) + sizeof(boot_progress_t);
+}
+
+/**
+ * @brief Firmware data package received, called in USB interrupt.
+ *        The package is copied into the current fill page buffer, and
+ *        USB OUT is re-armed at once if a page buffer is free.
  *
- * @param ep            USB endpoint.
  * @param nbytes        The size of the data request.
  *
  * @return None.
  */
-static void boot_out_callback(uint8_t ep, uint32_t nbytes)
+static void boot_firmware_data(uint32_t nbytes)
 {
-    if(boot_main_state == BOOT_REVE_WAIT)
-    {   
-        if (rece_message_packert.message_header.type == BOOT_CMD_FIRMWARE_DATA)
+    message_header_t *header = &rece_message_packert.message_header;
+    flash_write_info_t *info = &flash_write_info[flash_pipeline.fill];
+    message_header_t reply = {0};
+
+    /* Last package, CRC verification after all pages programmed */
+    if (header->request.bits.page_num_end == 1)
+    {
+        flash_pipeline.crc_pending = 1;
+        return;
+    }
+
+    /* First packet of one page data package */
+    if (header->request.bits.page_index_start == 1)
+    {
+        info->page_cur_point = 0;
+        info->page_cur_index = header->index;
+        info->page_cur_page = header->value;
+    }
+    /* The packet num or index does not match, request to retransmit the current subcontracting */
+    else if ((info->page_cur_page != header->value) || ((info->page_cur_index + 1) != header->index))
+    {
+        if (info->page_cur_page != header->value)
+            reply.request.bits.page_unmatched = 1;
+        else
+            reply.request.bits.page_index_unmatched = 1;
+        boot_reply_queue(reply.request.byte, info->page_cur_page, info->page_cur_index, 0);
+        usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+        return;
+    }
+    else
+    {
+        info->page_cur_index = header->index;
+    }
+
+    if (info->page_cur_page >= BOOT_APP_PAGE_NUM)
+    {
+        reply.request.bits.page_unmatched = 1;
+        boot_reply_queue(reply.request.byte, info->page_cur_page, info->page_cur_index, 0);
+        usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+        return;
+    }
+
+    nbytes = (nbytes < header->length) ? nbytes : header->length;
+    if (nbytes > (CHIP_FLASH_PAGE_SIZE - info->page_cur_point))
+        nbytes = CHIP_FLASH_PAGE_SIZE - info->page_cur_point;
+    memcpy((uint8_t *)info->page_cur_buffer + info->page_cur_point, rece_message_packert.message_data, nbytes);
+    info->page_cur_point += nbytes;
+
+    /* One page packet is not the last packet */
+    if (header->request.bits.page_index_end == 0)
+    {
+        reply.request.bits.ack = 1;
+        if (flash_pipeline.ack_window == 0)
+            boot_reply_queue(reply.request.byte, info->page_cur_page, info->page_cur_index, nbytes);
+        usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+        return;
+    }
+
+    if (info->page_cur_point != CHIP_FLASH_PAGE_SIZE)
+    {
+        reply.request.bits.page_subcontracting_miss = 1;
+        boot_reply_queue(reply.request.byte, info->page_cur_page, info->page_cur_index, nbytes);
+        usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+        return;
+    }
+
+    /* Page is full, hand it over to the programming loop */
+    info->page_last_length = nbytes;
+    info->page_reply = 1;
+    flash_pipeline.ready++;
+    if (flash_pipeline.ready < BOOT_PAGE_BUFFER_NUM)
+    {
+        flash_pipeline.fill = (flash_pipeline.fill + 1) % BOOT_PAGE_BUFFER_NUM;
+        usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+    }
+    else
+    {
+        flash_pipeline.out_pending = 1;
+    }
+}
+
+/**
+ * @brief Compressed firmware data package received, called in USB interrupt.
+ *        Value is the first page num of the stream, index is the package index,
+ *        USB OUT stays unarmed until the main loop has decoded the package.
+ *
+ * @param nbytes        The size of the data request.
+ *
+ * @return None.
+ */
+static void boot_firmware_lz_data(uint32_t nbytes)
+{
+    message_header_t *header = &rece_message_packert.message_header;
+    flash_write_info_t *info = &flash_write_info[flash_pipeline.fill];
+    message_header_t reply = {0};
+
+    /* Last package, CRC verification after all pages programmed */
+    if (header->request.bits.page_num_end == 1)
+    {
+        /* The image ends inside a page, program it padded with the erased value */
+        if ((info->page_cur_point) && (flash_pipeline.ready < BOOT_PAGE_BUFFER_NUM))
         {
-            /* Last package CRC verification */
-            if (rece_message_packert.message_header.request.bits.page_num_end == 1)
-            {
-                boot_main_state = BOOT_CRC_VERIFICATION;
-                return;
-            }
-            send_message_packert.message_header.type = BOOT_CMD_FIRMWARE_DATA_REPLY;
-            send_message_packert.message_header.request.byte = 0;
-            boot_main_state = BOOT_SEND_REPLY;
+            memset((uint8_t *)info->page_cur_buffer + info->page_cur_point, 0xFF, CHIP_FLASH_PAGE_SIZE - info->page_cur_point);
+            info->page_cur_point = CHIP_FLASH_PAGE_SIZE;
+            info->page_reply = 0;
+            flash_pipeline.lz_page++;
+            flash_pipeline.ready++;
+            flash_pipeline.fill = (flash_pipeline.fill + 1) % BOOT_PAGE_BUFFER_NUM;
+            flash_write_info[flash_pipeline.fill].page_cur_point = 0;
+        }
+        flash_pipeline.crc_pending = 1;
+        return;
+    }
 
-            /* One page packet is not the first packet */
-            if (rece_message_packert.message_header.request.bits.page_index_start == 0)
-            {
-                /* The packet num does not match */
-                if (flash_write_info.page_cur_page != rece_message_packert.message_header.value)
-                        send_message_packert.message_header.request.bits.page_unmatched = 1;
-                /* The packet index does not match */
-                if ((flash_write_info.page_cur_index + 1) != rece_message_packert.message_header.index)
-                        send_message_packert.message_header.request.bits.page_index_unmatched = 1;
-                
-                /* Request to retransmit the current subcontracting */
-                send_message_packert.message_header.value = flash_write_info.page_cur_page;
-                send_message_packert.message_header.index = flash_write_info.page_cur_index;
-                send_message_packert.message_header.length = 0;
-                return;     
-            }
-            
-            /* First packet of one page data package */
-            if (rece_message_packert.message_header.request.bits.page_index_start == 1)
-            {
-                flash_write_info.page_cur_point = 0;
-                flash_write_info.page_cur_index = 0;
-            }
+    /* First package of the stream, the decoder restarts at the given page */
+    if (header->request.bits.page_index_start == 1)
+    {
+        lz_decoder_init(&lz_decoder);
+        flash_write_info[flash_pipeline.fill].page_cur_point = 0;
+        flash_pipeline.lz_page = header->value;
+        flash_pipeline.lz_index = header->index;
+    }
+    /* A lost package breaks the stream, the host restarts it from the first package */
+    else if ((flash_pipeline.lz_index + 1) != header->index)
+    {
+        reply.request.bits.page_index_unmatched = 1;
+        boot_reply_queue(reply.request.byte, flash_pipeline.lz_page, flash_pipeline.lz_index, 0);
+        usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+        return;
+    }
+    else
+    {
+        flash_pipeline.lz_index = header->index;
+    }
 
-            flash_write_info.page_cur_page = rece_message_packert.message_header.value;
-            flash_write_info.page_cur_index = rece_message_packert.message_header.index;
-            send_message_packert.message_header.value = flash_write_info.page_cur_page;
+    nbytes = (nbytes < header->length) ? nbytes : header->length;
+    if (nbytes > sizeof(rece_message_packert.message_data))
+        nbytes = sizeof(rece_message_packert.message_data);
+    flash_pipeline.lz_length = nbytes;
+    flash_pipeline.lz_consumed = 0;
+    flash_pipeline.lz_pending = 1;
+}
 
-            nbytes = (nbytes < rece_message_packert.message_header.length) ? nbytes : rece_message_packert.message_header.length;
-            for (uint16_t i = 0; i < nbytes; i++)
-            {
-                flash_write_info.page_cur_buffer[flash_write_info.page_cur_point++] = rece_message_packert.message_data[i];
-            }
-            send_message_packert.message_header.length = nbytes;
+/**
+ * @brief USB boot has data requests.
+ *
+ * @param ep            USB endpoint.
+ * @param nbytes        The size of the data request.
+ *
+ * @return None.
+ */
+static void boot_out_callback(uint8_t ep, uint32_t nbytes)
+{
+    if ((boot_main_state == BOOT_REVE_WAIT) || (boot_main_state == BOOT_SEND_WAIT))
+    {
+        if (boot_main_state == BOOT_REVE_WAIT)
+            usb_wait_cnt = BOOT_USB_REVE_WAIT_TIME;
 
-            /* Last packet of one page data package, start to write to flash. 
-             * After write completion send the current packet receiving completion information
-             */
-            if (rece_message_packert.message_header.request.bits.page_index_end == 1)
-            {
-                if (flash_write_info.page_cur_point == CHIP_FLASH_PAGE_SIZE)
-                {
-                    send_message_packert.message_header.request.bits.ack = 1;
-                    boot_main_state = BOOT_WRITE_FLASH;
-                }    
-                else
-                {
-                    send_message_packert.message_header.request.bits.page_subcontracting_miss = 1;
-                }    
-            }    
-            /* One page packet is not the last packet,
-             * directly send the current packet receiving completion information
-             */
-            else
-            {
-                send_message_packert.message_header.request.bits.ack = 1;
-                boot_main_state = BOOT_SEND_REPLY;
-            }    
+        if (rece_message_packert.message_header.type == BOOT_CMD_FIRMWARE_DATA)
+        {
+            boot_firmware_data(nbytes);
+        }
+        else if (rece_message_packert.message_header.type == BOOT_CMD_FIRMWARE_LZ_DATA)
+        {
+            boot_firmware_lz_data(nbytes);
         }
         else if (rece_message_packert.message_header.type == BOOT_CMD_REVE_PAGE_SIZE)
         {
+            /* Index is the ack window the host asks for, 0 for lockstep replies,
+             * length is the image size in pages, 0 if unknown
+             */
+            flash_pipeline.ack_window = rece_message_packert.message_header.index;
+            flash_pipeline.image_pages = rece_message_packert.message_header.length;
+            if (flash_pipeline.ack_window > BOOT_ACK_WINDOW_MAX)
+                flash_pipeline.ack_window = BOOT_ACK_WINDOW_MAX;
             boot_main_state = BOOT_SEND_PAGE_SIZE;
-        }  
+        }
+        else
+        {
+            usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+        }
     }
 }
 
@@ -203,14 +435,193 @@ static void boot_in_callback(uint8_t ep, uint32_t nbytes)
                 if (send_message_packert.message_header.request.bits.crc_unmatched == 1)
                     boot_main_state = BOOT_TIMEOUT;
                 else
-                    boot_main_state = BOOT_END;    
-            }    
+                    boot_main_state = BOOT_END;
+            }
             else
             {
                 boot_main_state = BOOT_REVE_WAIT;
                 usb_wait_cnt = BOOT_USB_REVE_WAIT_TIME;
-            }    
-        }    
+            }
+        }
+    }
+}
+
+/**
+ * @brief Get the largest block to erase at a page, only when changes are dense
+ *        and the whole block is covered by the incoming image.
+ *
+ * @param page          Page num.
+ *
+ * @return Block size, CHIP_FLASH_PAGE_SIZE if only the page should be erased.
+ */
+static uint32_t boot_erase_size(uint16_t page)
+{
+    static const uint32_t block_size[] = {CHIP_FLASH_BLOCK64_SIZE, CHIP_FLASH_BLOCK32_SIZE, CHIP_FLASH_SECTOR_SIZE};
+    uint32_t addr = CHIP_APP_START + page * CHIP_FLASH_PAGE_SIZE;
+    uint32_t image_end = CHIP_APP_START + flash_pipeline.image_pages * CHIP_FLASH_PAGE_SIZE;
+
+    if ((flash_pipeline.image_pages == 0) || (flash_pipeline.changed_run < BOOT_DENSE_PAGE_NUM))
+        return CHIP_FLASH_PAGE_SIZE;
+
+    for (uint8_t i = 0; i < sizeof(block_size) / sizeof(block_size[0]); i++)
+    {
+        if (((addr & (block_size[i] - 1)) == 0) && ((addr + block_size[i]) <= image_end))
+            return block_size[i];
+    }
+
+    return CHIP_FLASH_PAGE_SIZE;
+}
+
+/**
+ * @brief Check whether a page must be erased before programming, only an erased page
+ *        is programmed directly, re-programming written cells is not defined.
+ *
+ * @param flash         A pointer to the FLASH page.
+ *
+ * @return 1 : erase needed.
+ */
+static uint8_t boot_erase_needed(const uint32_t *flash)
+{
+    for (uint32_t i = 0; i < CHIP_FLASH_PAGE_SIZE / 4; i++)
+    {
+        if (flash[i] != 0xFFFFFFFF)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Program the oldest full page buffer, free it and resume USB OUT if it was held.
+ *        Pages identical to FLASH are skipped, and dense changes use block erase.
+ *
+ * @return 0 : ok, 1 : flash error.
+ */
+static uint8_t boot_flash_program(void)
+{
+    flash_write_info_t *info = &flash_write_info[flash_pipeline.program];
+    uint32_t addr = CHIP_APP_START + info->page_cur_page * CHIP_FLASH_PAGE_SIZE;
+    uint32_t erase_size;
+    uint8_t retry;
+
+    if (memcmp((const void *)addr, info->page_cur_buffer, CHIP_FLASH_PAGE_SIZE) == 0)
+    {
+        flash_pipeline.changed_run = 0;
+        flash_pipeline.pages_skipped++;
+    }
+    else
+    {
+        flash_pipeline.changed_run++;
+        if (boot_erase_needed((const uint32_t *)addr))
+        {
+            erase_size = boot_erase_size(info->page_cur_page);
+            for (retry = BOOT_FLASH_WRITE_WAIT_TIME; retry > 0; retry--)
+            {
+                if (erase_size == CHIP_FLASH_PAGE_SIZE)
+                {
+                    if (flash_erase_256byte(addr) == 0)
+                        break;
+                }
+                else if (flash_erase_block(addr, erase_size) == 0)
+                {
+                    break;
+                }
+            }
+            if (retry == 0)
+                return 1;
+        }
+
+        for (retry = BOOT_FLASH_WRITE_WAIT_TIME; retry > 0; retry--)
+        {
+            if (flash_program_256byte(addr, info->page_cur_buffer) == 0)
+                break;
+        }
+        if (retry == 0)
+            return 1;
+        flash_pipeline.pages_written++;
+    }
+
+    __disable_irq();
+    flash_pipeline.program = (flash_pipeline.program + 1) % BOOT_PAGE_BUFFER_NUM;
+    flash_pipeline.ready--;
+    /* Lockstep compressed packages are acked by the decoder */
+    if ((flash_pipeline.ack_window) || (info->page_reply))
+    {
+        flash_pipeline.unacked++;
+        flash_pipeline.ack_page = info->page_cur_page;
+        flash_pipeline.ack_index = info->page_cur_index;
+        flash_pipeline.ack_length = info->page_last_length;
+    }
+    if (flash_pipeline.out_pending)
+    {
+        flash_pipeline.out_pending = 0;
+        flash_pipeline.fill = (flash_pipeline.fill + 1) % BOOT_PAGE_BUFFER_NUM;
+        usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+    }
+    boot_ack_pages();
+    __enable_irq();
+
+    return 0;
+}
+
+/**
+ * @brief Decode the pending compressed package into the page buffers,
+ *        stops when both page buffers are full and continues after programming.
+ *
+ * @return None.
+ */
+static void boot_lz_decode(void)
+{
+    flash_write_info_t *info;
+    message_header_t reply = {0};
+    uint32_t in_len;
+
+    while (flash_pipeline.ready < BOOT_PAGE_BUFFER_NUM)
+    {
+        info = &flash_write_info[flash_pipeline.fill];
+        if (info->page_cur_point == 0)
+            info->page_cur_page = flash_pipeline.lz_page;
+
+        in_len = flash_pipeline.lz_length - flash_pipeline.lz_consumed;
+        info->page_cur_point += lz_decode(&lz_decoder, rece_message_packert.message_data + flash_pipeline.lz_consumed, &in_len,
+                                          (uint8_t *)info->page_cur_buffer + info->page_cur_point, CHIP_FLASH_PAGE_SIZE - info->page_cur_point);
+        flash_pipeline.lz_consumed += in_len;
+
+        __disable_irq();
+        /* Stream runs past the APP region, drop the package */
+        if ((info->page_cur_point) && (info->page_cur_page >= BOOT_APP_PAGE_NUM))
+        {
+            info->page_cur_point = 0;
+            flash_pipeline.lz_pending = 0;
+            reply.request.bits.page_unmatched = 1;
+            boot_reply_queue(reply.request.byte, info->page_cur_page, flash_pipeline.lz_index, 0);
+            usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+            __enable_irq();
+            break;
+        }
+
+        /* Page is full, hand it over to the programming loop */
+        if (info->page_cur_point == CHIP_FLASH_PAGE_SIZE)
+        {
+            info->page_reply = 0;
+            flash_pipeline.lz_page++;
+            flash_pipeline.ready++;
+            flash_pipeline.fill = (flash_pipeline.fill + 1) % BOOT_PAGE_BUFFER_NUM;
+            flash_write_info[flash_pipeline.fill].page_cur_point = 0;
+        }
+        /* Package decoded, receive the next one */
+        if (flash_pipeline.lz_consumed == flash_pipeline.lz_length)
+        {
+            flash_pipeline.lz_pending = 0;
+            if (flash_pipeline.ack_window == 0)
+            {
+                reply.request.bits.ack = 1;
+                boot_reply_queue(reply.request.byte, flash_pipeline.lz_page, flash_pipeline.lz_index, flash_pipeline.lz_length);
+            }
+            usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
+            __enable_irq();
+            break;
+        }
+        __enable_irq();
     }
 }
 
@@ -223,7 +634,9 @@ static void usb_data_init(void)
 {
     boot_main_state = BOOT_IDLE;
     usb_wait_cnt = BOOT_USB_WAIT_FOREVER;
-    memset(&flash_write_info, 0, sizeof(flash_write_info_t));
+    memset(&flash_write_info, 0, sizeof(flash_write_info));
+    memset(&flash_pipeline, 0, sizeof(flash_pipeline_t));
+    lz_decoder_init(&lz_decoder);
     memset(&rece_message_packert, 0, sizeof(message_packert_t));
     memset(&send_message_packert, 0, sizeof(message_packert_t));
 }
@@ -255,7 +668,7 @@ void usb_interface_init(void)
     usbd_add_interface(&dap_intf);
     usbd_add_endpoint(&boot_out_ep);
     usbd_add_endpoint(&boot_in_ep);
-       
+
     usbd_initialize();
 }
 
@@ -275,7 +688,7 @@ uint8_t boot_update_main(void)
                     boot_main_state = BOOT_REVE_WAIT;
                     usb_wait_cnt = BOOT_USB_WAIT_FOREVER;
                     usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
-                }    
+                }
             }
             break;
         case BOOT_SEND_PAGE_SIZE:
@@ -286,7 +699,7 @@ uint8_t boot_update_main(void)
                 send_message_packert.message_header.type = BOOT_CMD_SEND_PAGE_SIZE;
                 send_message_packert.message_header.request.byte = 0;
                 send_message_packert.message_header.value = CHIP_FLASH_PAGE_SIZE;
-                send_message_packert.message_header.index = 0;
+                send_message_packert.message_header.index = flash_pipeline.ack_window;
                 send_message_packert.message_header.length = 0;
                 usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
                 usbd_ep_start_write(DAP_IN_EP, (uint8_t *)&send_message_packert, sizeof(message_header_t));
@@ -296,40 +709,11 @@ uint8_t boot_update_main(void)
             {
                 boot_main_state = BOOT_SEND_WAIT;
                 usb_wait_cnt = BOOT_USB_SEND_WAIT_TIME;
-                usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
-                usbd_ep_start_write(DAP_IN_EP, (uint8_t *)&send_message_packert, sizeof(message_header_t));
-            }
-            break;
-        case BOOT_WRITE_FLASH:
-            {
-                usb_wait_cnt = BOOT_FLASH_WRITE_WAIT_TIME;
-                while (flash_erase_256byte(CHIP_APP_START + flash_write_info.page_cur_page * CHIP_FLASH_PAGE_SIZE))
-                {
-                    usb_wait_cnt--;
-                    if (usb_wait_cnt == 0)
-                    {
-                        boot_main_state = BOOT_TIMEOUT;
-                        break;
-                    }    
-                }
-                usb_wait_cnt = BOOT_FLASH_WRITE_WAIT_TIME;
-                while (flash_program_256byte(CHIP_APP_START + flash_write_info.page_cur_page * CHIP_FLASH_PAGE_SIZE,
-                                        (uint32_t *)&flash_write_info.page_cur_buffer))
-                {
-                    usb_wait_cnt--;
-                    if (usb_wait_cnt == 0)
-                    {
-                        boot_main_state = BOOT_TIMEOUT;
-                        break;
-                    }
-                }
-                if (boot_main_state == BOOT_TIMEOUT)
-                    break;
-
-                boot_main_state = BOOT_SEND_WAIT;
-                usb_wait_cnt = BOOT_USB_SEND_WAIT_TIME;
-                usbd_ep_start_read(DAP_OUT_EP, (uint8_t *)&rece_message_packert, DAP_PACKET_SIZE);
-                usbd_ep_start_write(DAP_IN_EP, (uint8_t *)&send_message_packert, sizeof(message_header_t));            
+                __disable_irq();
+                send_message_packert.message_header = flash_pipeline.reply_header;
+                flash_pipeline.reply_pending = 0;
+                __enable_irq();
+                usbd_ep_start_write(DAP_IN_EP, (uint8_t *)&send_message_packert, boot_progress_append());
             }
             break;
         case BOOT_CRC_VERIFICATION:
@@ -344,30 +728,62 @@ uint8_t boot_update_main(void)
                 send_message_packert.message_header.length = 0;
                 uint32_t crc_value = __UNALIGNED_UINT32_READ(rece_message_packert.message_data);
                 if (crc_value != crc_cal_data((uint32_t *)CHIP_APP_START, (rece_message_packert.message_header.value * CHIP_FLASH_PAGE_SIZE) / 4))
-                    send_message_packert.message_header.request.bits.crc_unmatched = 1;    
-                usbd_ep_start_write(DAP_IN_EP, (uint8_t *)&send_message_packert, sizeof(message_header_t));
+                    send_message_packert.message_header.request.bits.crc_unmatched = 1;
+                usbd_ep_start_write(DAP_IN_EP, (uint8_t *)&send_message_packert, boot_progress_append());
             }
-            break;       
+            break;
         case BOOT_SEND_WAIT:
         case BOOT_REVE_WAIT:
             {
-                if (usb_wait_cnt != BOOT_USB_WAIT_FOREVER)         
+                /* Program pages in the background, USB keeps receiving the next page */
+                if (flash_pipeline.ready)
+                {
+                    if (boot_flash_program())
+                    {
+                        boot_main_state = BOOT_TIMEOUT;
+                        break;
+                    }
+                }
+
+                if (flash_pipeline.lz_pending)
+                    boot_lz_decode();
+
+                if (boot_main_state == BOOT_REVE_WAIT)
+                {
+                    /* Acks held back by an error reply, and the last page ack, go before the CRC reply */
+                    __disable_irq();
+                    if (!flash_pipeline.reply_pending)
+                        boot_ack_pages();
+                    __enable_irq();
+                    if (flash_pipeline.reply_pending)
+                    {
+                        boot_main_state = BOOT_SEND_REPLY;
+                        break;
+                    }
+                    if ((flash_pipeline.crc_pending) && (flash_pipeline.ready == 0) && (flash_pipeline.unacked == 0))
+                    {
+                        boot_main_state = BOOT_CRC_VERIFICATION;
+                        break;
+                    }
+                }
+
+                if (usb_wait_cnt != BOOT_USB_WAIT_FOREVER)
                 {
                     if (usb_wait_cnt > 0)
                         usb_wait_cnt--;
                     else
                         boot_main_state = BOOT_TIMEOUT;
                 }
-            }             
+            }
             break;
         case BOOT_TIMEOUT:
             usb_data_init();
-            break;   
+            break;
         case BOOT_END:
             flash_Lock();
-            break;    
+            break;
         default:
-            break;    
+            break;
     }
     return boot_main_state;
 }
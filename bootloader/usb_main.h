@@ -12,7 +12,6 @@ typedef enum
     BOOT_IDLE,
     BOOT_SEND_PAGE_SIZE,
     BOOT_SEND_REPLY,
-    BOOT_WRITE_FLASH,
     BOOT_CRC_VERIFICATION,
     BOOT_SEND_WAIT,
     BOOT_REVE_WAIT,
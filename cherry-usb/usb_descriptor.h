@@ -6,12 +6,14 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-11     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       add notify interrupt endpoint.
+ * 2026-10-18     SecondHandCoder       add RTT CDC ACM interface.
  */
 
 
 #include "usbd_core.h"
 #include "ch32f205_dap_config.h"
-#if (DAP_UART != 0)
+#if (DAP_UART != 0) || (DAP_RTT != 0)
 #include "usbd_cdc.h"
 #endif
 
@@ -23,6 +25,13 @@
 #define CDC_OUT_EP                  0x04
 #define CDC_INT_EP                  0x85
 
+#define NOTIFY_INT_EP               0x86
+#define NOTIFY_EP_SIZE              16
+
+#define RTT_IN_EP                   0x87
+#define RTT_OUT_EP                  0x08
+#define RTT_INT_EP                  0x89
+
 #define USBD_VID                    0x1A86
 #define USBD_PID                    0x0204
 #define USBD_MAX_POWER              500
@@ -31,13 +40,34 @@
 #define CMSIS_DAP_INTERFACE_SIZE (9 + 7 + 7)
 
 #if (DAP_UART != 0)
-#define USB_CONFIG_SIZE (9 + CMSIS_DAP_INTERFACE_SIZE + CDC_ACM_DESCRIPTOR_LEN)
-#define INTF_NUM        3
+#define CDC_INTERFACE_SIZE  CDC_ACM_DESCRIPTOR_LEN
+#define CDC_INTF_NUM        2
+#else
+#define CDC_INTERFACE_SIZE  0
+#define CDC_INTF_NUM        0
+#endif
+
+#if (DAP_NOTIFY != 0)
+#define NOTIFY_INTERFACE_SIZE (9 + 7)
+#define NOTIFY_INTF_NUM     1
+#else
+#define NOTIFY_INTERFACE_SIZE 0
+#define NOTIFY_INTF_NUM     0
+#endif
+
+#if (DAP_RTT != 0)
+#define RTT_INTERFACE_SIZE  CDC_ACM_DESCRIPTOR_LEN
+#define RTT_INTF_NUM        2
 #else
-#define USB_CONFIG_SIZE (9 + CMSIS_DAP_INTERFACE_SIZE)
-#define INTF_NUM        1
+#define RTT_INTERFACE_SIZE  0
+#define RTT_INTF_NUM        0
 #endif
 
+#define NOTIFY_INTF         (1 + CDC_INTF_NUM)
+#define RTT_INTF            (NOTIFY_INTF + NOTIFY_INTF_NUM)
+#define USB_CONFIG_SIZE     (9 + CMSIS_DAP_INTERFACE_SIZE + CDC_INTERFACE_SIZE + NOTIFY_INTERFACE_SIZE + RTT_INTERFACE_SIZE)
+#define INTF_NUM            (1 + CDC_INTF_NUM + NOTIFY_INTF_NUM + RTT_INTF_NUM)
+
 #ifdef CONFIG_USB_HS
 #if DAP_PACKET_SIZE != 512
 #error "DAP_PACKET_SIZE must be 512 in hs"
@@ -58,14 +88,19 @@
 #define WINUSB_FUNCTION_SUBSET_HEADER_SIZE 8
 #define WINUSB_FEATURE_COMPATIBLE_ID_SIZE  20
 
-#if (DAP_UART != 0)
+#if (INTF_NUM > 1)
 #define FUNCTION_SUBSET_LEN                160
 #else
 #define FUNCTION_SUBSET_LEN                152
 #endif
+#if (DAP_NOTIFY != 0)
+#define NOTIFY_FUNCTION_SUBSET_LEN         160
+#else
+#define NOTIFY_FUNCTION_SUBSET_LEN         0
+#endif
 #define DEVICE_INTERFACE_GUIDS_FEATURE_LEN 132
 
-#define USBD_WINUSB_DESC_SET_LEN (WINUSB_DESCRIPTOR_SET_HEADER_SIZE + USBD_BULK_ENABLE * FUNCTION_SUBSET_LEN)
+#define USBD_WINUSB_DESC_SET_LEN (WINUSB_DESCRIPTOR_SET_HEADER_SIZE + USBD_BULK_ENABLE * FUNCTION_SUBSET_LEN + NOTIFY_FUNCTION_SUBSET_LEN)
 
 __ALIGN_BEGIN const uint8_t USBD_WinUSBDescriptorSetDescriptor[] =
 {
@@ -74,7 +109,7 @@ __ALIGN_BEGIN const uint8_t USBD_WinUSBDescriptorSetDescriptor[] =
     0x00, 0x00, 0x03, 0x06, /* >= Win 8.1 */    /* dwWindowsVersion*/
     WBVAL(USBD_WINUSB_DESC_SET_LEN),            /* wDescriptorSetTotalLength */
 #if USBD_BULK_ENABLE
-#if (DAP_UART != 0)
+#if (INTF_NUM > 1)
     WBVAL(WINUSB_FUNCTION_SUBSET_HEADER_SIZE),  /* wLength */
     WBVAL(WINUSB_SUBSET_HEADER_FUNCTION_TYPE),  /* wDescriptorType */
     0,                                          /* bFirstInterface USBD_BULK_IF_NUM*/
@@ -99,6 +134,32 @@ __ALIGN_BEGIN const uint8_t USBD_WinUSBDescriptorSetDescriptor[] =
     '4', 0, '6', 0, '6', 0, '3', 0, '-', 0,
     'A', 0, 'A', 0, '3', 0, '6', 0, '-',
     0, '1', 0, 'A', 0, 'A', 0, 'E', 0, '4', 0, '6', 0, '4', 0, '6', 0, '3', 0, '7', 0, '7', 0, '6', 0,
+    '}', 0, 0, 0, 0, 0,
+#endif
+#if (DAP_NOTIFY != 0)
+    WBVAL(WINUSB_FUNCTION_SUBSET_HEADER_SIZE),  /* wLength */
+    WBVAL(WINUSB_SUBSET_HEADER_FUNCTION_TYPE),  /* wDescriptorType */
+    NOTIFY_INTF,                                /* bFirstInterface */
+    0,                                          /* bReserved */
+    WBVAL(NOTIFY_FUNCTION_SUBSET_LEN),          /* wSubsetLength */
+    WBVAL(WINUSB_FEATURE_COMPATIBLE_ID_SIZE),   /* wLength */
+    WBVAL(WINUSB_FEATURE_COMPATIBLE_ID_TYPE),   /* wDescriptorType */
+    'W', 'I', 'N', 'U', 'S', 'B', 0, 0,         /* CompatibleId*/
+    0, 0, 0, 0, 0, 0, 0, 0,                     /* SubCompatibleId*/
+    WBVAL(DEVICE_INTERFACE_GUIDS_FEATURE_LEN),  /* wLength */
+    WBVAL(WINUSB_FEATURE_REG_PROPERTY_TYPE),    /* wDescriptorType */
+    WBVAL(WINUSB_PROP_DATA_TYPE_REG_MULTI_SZ),  /* wPropertyDataType */
+    WBVAL(42),                                  /* wPropertyNameLength */
+    'D', 0, 'e', 0, 'v', 0, 'i', 0, 'c', 0, 'e', 0,
+    'I', 0, 'n', 0, 't', 0, 'e', 0, 'r', 0, 'f', 0, 'a', 0, 'c', 0, 'e', 0,
+    'G', 0, 'U', 0, 'I', 0, 'D', 0, 's', 0, 0, 0,
+    WBVAL(80),                                  /* wPropertyDataLength */
+    '{', 0,
+    '6', 0, 'F', 0, '2', 0, 'D', 0, '8', 0, 'C', 0, '1', 0, '4', 0, '-', 0,
+    '5', 0, 'A', 0, '7', 0, 'E', 0, '-', 0,
+    '4', 0, 'B', 0, '3', 0, '1', 0, '-', 0,
+    '9', 0, 'C', 0, '0', 0, '2', 0, '-',
+    0, 'E', 0, '8', 0, '4', 0, '1', 0, '7', 0, 'A', 0, '6', 0, 'D', 0, '2', 0, 'C', 0, '5', 0, '9', 0,
     '}', 0, 0, 0, 0, 0
 #endif
 };
@@ -143,6 +204,15 @@ const uint8_t cmsisdap_descriptor[] =
 #if (DAP_UART != 0)     
     CDC_ACM_DESCRIPTOR_INIT(0x01, CDC_INT_EP, CDC_OUT_EP, CDC_IN_EP, DAP_PACKET_SIZE, 0x00),
 #endif  
+#if (DAP_NOTIFY != 0)
+    /* Interface notify */
+    USB_INTERFACE_DESCRIPTOR_INIT(NOTIFY_INTF, 0x00, 0x01, 0xFF, 0x00, 0x00, 0x00),
+    /* Endpoint IN 6 */
+    USB_ENDPOINT_DESCRIPTOR_INIT(NOTIFY_INT_EP, USB_ENDPOINT_TYPE_INTERRUPT, NOTIFY_EP_SIZE, 0x04),
+#endif
+#if (DAP_RTT != 0)
+    CDC_ACM_DESCRIPTOR_INIT(RTT_INTF, RTT_INT_EP, RTT_OUT_EP, RTT_IN_EP, DAP_PACKET_SIZE, 0x00),
+#endif
     /* String 0 (LANGID) */
     USB_LANGID_INIT(USBD_LANGID_STRING),
     /* String 1 (Manufacturer) */
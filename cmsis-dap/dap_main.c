@@ -6,6 +6,18 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-12     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       add MEM-AP access for probe side services.
+ * 2026-10-18     SecondHandCoder       drop the probe side topology cache on connect and line reset.
+ * 2026-10-18     SecondHandCoder       add SWD multi-drop target switch.
+ * 2026-10-18     SecondHandCoder       shift JTAG sequences from the request buffer without the 64-bit limit.
+ * 2026-10-18     SecondHandCoder       keep the loaded JTAG IR across transfer commands.
+ * 2026-10-18     SecondHandCoder       precompute JTAG DR scans on chain configure.
+ * 2026-10-18     SecondHandCoder       shift JTAG block reads as DR trains.
+ * 2026-10-18     SecondHandCoder       add JTAG scan chain detection.
+ * 2026-10-18     SecondHandCoder       add RISC-V DTM and DMI access.
+ * 2026-10-18     SecondHandCoder       add device IR/DR scans for boundary scan.
+ * 2026-10-18     SecondHandCoder       merge JTAG sequence items with the same TMS into SPI spans.
+ * 2026-10-18     SecondHandCoder       add raw TAP access for the SVF player.
  */
 
 #include "dap_main.h"
@@ -56,16 +68,71 @@ typedef struct
         uint8_t ir_length[DAP_JTAG_DEV_CNT];    /* JTAG IR Length in bits */
         uint16_t ir_before[DAP_JTAG_DEV_CNT];   /* JTAG bits before IR */
         uint16_t ir_after[DAP_JTAG_DEV_CNT];    /* JTAG Bits after IR */
+        uint8_t ir_cur[DAP_JTAG_DEV_CNT];       /* JTAG IR loaded in the device, 0 : unknown or BYPASS */
 #endif
-        uint64_t buf_tdi;                       /* JTAG TDI buffer*/
-        uint64_t buf_tms;                       /* JTAG TMS buffer*/
-        uint64_t buf_tdo;                       /* JTAG TDO buffer*/
     } jtag_dev;
 #endif    
 } dap_info_t;
 
 static dap_info_t dap_info;
 
+#if (DAP_JTAG != 0)
+/* Constant TMS level and discarded TDO of SWJ sequences in JTAG mode, 256 bits max */
+static const uint8_t jtag_seq_high[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+static uint8_t jtag_seq_tdo[32];
+/* TDI gathered and TDO discarded of merged JTAG sequence items */
+static uint8_t jtag_span_tdi[DAP_PACKET_SIZE];
+static uint8_t jtag_span_tdo[DAP_PACKET_SIZE];
+#endif
+
+/* MEM-AP access info, the host DP/AP state is restored after probe side accesses */
+typedef struct
+{
+    uint8_t active;                             /* Access session is open */
+    uint8_t saved;                              /* CSW and TAR of the host are saved */
+    uint8_t ap;                                 /* AP num of the session */
+    uint8_t error;                              /* A transfer failed in this session */
+    uint8_t host_select_valid;                  /* Host has written DP SELECT since connect */
+    uint32_t host_select;                       /* DP SELECT last written by the host */
+    uint32_t select;                            /* DP SELECT written by the session */
+    uint32_t csw;                               /* AP CSW saved from the host */
+    uint32_t cur_csw;                           /* AP CSW written by the session */
+    uint32_t tar;                               /* AP TAR saved from the host */
+} dap_ap_access_t;
+
+static dap_ap_access_t dap_ap_access;
+
+#if (DAP_SWD != 0)
+/* SWD multi-drop target info, DP SELECT of the host is kept per target */
+typedef struct
+{
+    uint8_t count;                                          /* Targets in the table */
+    uint8_t current;                                        /* Selected target, DAP_SWD_TARGET_NONE : none */
+    uint8_t host_select_valid[DAP_SWD_TARGET_CNT];          /* Host has written DP SELECT of the target */
+    uint32_t targetsel[DAP_SWD_TARGET_CNT];                 /* TARGETSEL of each target */
+    uint32_t dpidr[DAP_SWD_TARGET_CNT];                     /* DPIDR read at the last switch */
+    uint32_t host_select[DAP_SWD_TARGET_CNT];               /* DP SELECT last written by the host */
+} dap_swd_target_t;
+
+static dap_swd_target_t dap_swd_target;
+#endif
+
+#if (DAP_JTAG != 0)
+/* RISC-V debug transport module of a JTAG device */
+typedef struct
+{
+    uint8_t valid;                              /* DTM is selected */
+    uint8_t index;                              /* JTAG device index of the DTM */
+    uint8_t abits;                              /* DMI address bits */
+    uint8_t idle;                               /* Run-Test/Idle cycles after a DMI scan */
+} dap_riscv_dtm_t;
+
+static dap_riscv_dtm_t dap_riscv_dtm;
+#endif
+
 /* DAP transfer info */
 typedef struct
 {
@@ -80,6 +147,58 @@ typedef struct
 const char DAP_FW_Ver[] = DAP_FW_VER;
 #endif
 
+/**
+ * @brief Forget the loaded JTAG IR, the next access scans IR again. Call it after anything
+ *        that may move the TAP state outside of the IR/DR scans.
+ *
+ * @return None.
+ */
+void dap_jtag_ir_invalidate(void)
+{
+#if ((DAP_JTAG != 0) && (DAP_JTAG_DEV_CNT != 0))
+    rt_memset(dap_info.jtag_dev.ir_cur, 0, sizeof(dap_info.jtag_dev.ir_cur));
+#endif
+}
+
+/**
+ * @brief Forget the loaded JTAG IR when a transfer ends without a valid ack, the chain may be lost.
+ *
+ * @param ack               Ack of transfer.
+ *
+ * @return None.
+ */
+static void dap_jtag_ack_check(uint16_t ack)
+{
+    ack &= ~DAP_TRANSFER_MISMATCH;
+    if ((ack != DAP_TRANSFER_OK) && (ack != DAP_TRANSFER_WAIT))
+        dap_jtag_ir_invalidate();
+}
+
+#if (DAP_JTAG != 0)
+/**
+ * @brief Load IR of the selected JTAG device, the scan is skipped if it is loaded already.
+ *        The other devices are put into BYPASS by the scan.
+ *
+ * @param ir                IR value.
+ *
+ * @return None.
+ */
+static void dap_jtag_load_ir(uint8_t ir)
+{
+    uint8_t index = dap_info.jtag_dev.index;
+
+    if (dap_info.jtag_dev.ir_cur[index] == ir)
+        return;
+
+    dap_jtag_ir(ir,
+                dap_info.jtag_dev.ir_length[index],
+                dap_info.jtag_dev.ir_before[index],
+                dap_info.jtag_dev.ir_after[index]);
+    dap_jtag_ir_invalidate();
+    dap_info.jtag_dev.ir_cur[index] = ir;
+}
+#endif
+
 
 /**
  * @brief DAP get info.
@@ -370,6 +489,15 @@ static void dap_connect(uint8_t* request, uint8_t* response, dap_transfer_t *tra
             port = DAP_PORT_DISABLED;
     }
     dap_info.port = port;
+    dap_ap_access.host_select_valid = false;
+    dap_vendor_topology_reset();
+    dap_jtag_ir_invalidate();
+#if (DAP_SWD != 0)
+    dap_swd_target.current = DAP_SWD_TARGET_NONE;
+#endif
+#if (DAP_JTAG != 0)
+    dap_riscv_dtm.valid = false;
+#endif
     response[transfer->resp_ptr++] = port;
 }    
 
@@ -386,6 +514,15 @@ static void dap_disconnect(uint8_t* request, uint8_t* response, dap_transfer_t *
 {
     port_deinit(dap_info.port);
     dap_info.port = DAP_PORT_DISABLED;
+    dap_ap_access.host_select_valid = false;
+    dap_vendor_topology_reset();
+    dap_jtag_ir_invalidate();
+#if (DAP_SWD != 0)
+    dap_swd_target.current = DAP_SWD_TARGET_NONE;
+#endif
+#if (DAP_JTAG != 0)
+    dap_riscv_dtm.valid = false;
+#endif
     response[transfer->resp_ptr++] = DAP_OK;
 }
 
@@ -402,7 +539,10 @@ static void dap_delay(uint8_t* request, uint8_t* response, dap_transfer_t *trans
 {
     uint32_t delay_us = __UNALIGNED_UINT16_READ(request + transfer->req_ptr);
     transfer->req_ptr += 2;
-    rt_hw_us_delay(delay_us);
+    if (delay_us >= HRTIMER_SLEEP_MIN_US)
+        dap_hrtimer_sleep(delay_us);
+    else
+        rt_hw_us_delay(delay_us);
     response[transfer->resp_ptr++] = DAP_OK;
 }
 
@@ -417,6 +557,7 @@ static void dap_delay(uint8_t* request, uint8_t* response, dap_transfer_t *trans
  */
 static void dap_reset_target(uint8_t* request, uint8_t* response, dap_transfer_t *transfer)
 {
+    dap_jtag_ir_invalidate();
     response[transfer->resp_ptr++] = DAP_OK;
     response[transfer->resp_ptr++] = 0;
 }
@@ -438,6 +579,10 @@ static void dap_swj_pin(uint8_t* request, uint8_t* response, dap_transfer_t *tra
     uint32_t delay_us = __UNALIGNED_UINT32_READ(request + transfer->req_ptr + 2);
     transfer->req_ptr += 6U;
 
+    /* TAP may leave Run-Test/Idle or be reset */
+    if (select & ((1U << DAP_SWJ_SWCLK_TCK) | (1U << DAP_SWJ_SWDIO_TMS) | (1U << DAP_SWJ_nTRST) | (1U << DAP_SWJ_nRESET)))
+        dap_jtag_ir_invalidate();
+
     if (select & (1U << DAP_SWJ_SWCLK_TCK))
     {
         DAP_SWD_TCK_TO_OPP();
@@ -603,6 +748,14 @@ static void dap_swj_sequence(uint8_t* request, uint8_t* response, dap_transfer_t
 
     if (!bitlen)
         bitlen = 256U;
+    /* line reset and SWJ switch sequences are at least 50 bits */
+    if (bitlen >= 50U)
+    {
+        dap_vendor_topology_reset();
+    #if (DAP_SWD != 0)
+        dap_swd_target.current = DAP_SWD_TARGET_NONE;
+    #endif
+    }
 
     switch (dap_info.port)
     {
@@ -618,15 +771,12 @@ static void dap_swj_sequence(uint8_t* request, uint8_t* response, dap_transfer_t
     #if (DAP_JTAG != 0)      
         case DAP_PORT_JTAG:
             {
-                bitlen = MIN(bitlen, 64U);
-                uint8_t bytes = (bitlen + 7) >> 3;
-                rt_memcpy(&dap_info.jtag_dev.buf_tms, request + transfer->req_ptr, bytes);
-                transfer->req_ptr += bytes;
-                dap_info.jtag_dev.buf_tdi = 0xFFFFFFFFFFFFFFFF;
+                dap_jtag_ir_invalidate();
                 dap_jtag_raw(bitlen,
-                             (uint8_t*)&dap_info.jtag_dev.buf_tms,
-                             (uint8_t*)&dap_info.jtag_dev.buf_tdi,
-                             (uint8_t*)&dap_info.jtag_dev.buf_tdo);
+                             request + transfer->req_ptr,
+                             (uint8_t*)jtag_seq_high,
+                             jtag_seq_tdo);
+                transfer->req_ptr += ((bitlen + 7) >> 3);
                 response[transfer->resp_ptr++] = DAP_OK;
             }    
             break;
@@ -741,70 +891,97 @@ static void dap_jtag_sequence(uint8_t* request, uint8_t* response, dap_transfer_
 #endif            
     transfer->transfer_cnt = 0;
     uint16_t transfer_num = request[transfer->req_ptr++];
+#if (DAP_JTAG != 0)
+    dap_jtag_ir_invalidate();
+#endif
 
     while (transfer->transfer_cnt < transfer_num)
     {
-        uint8_t info = request[transfer->req_ptr++];
-        uint8_t bitlen = info & JTAG_SEQUENCE_TCK;
+        uint8_t info = request[transfer->req_ptr];
+        uint32_t span_bits = 0;
+        uint32_t span_bytes = 0;
 
-        if (bitlen == 0)
-            bitlen = 64U;
+        /* Items with the same TMS and TDO capture are one span, only the last may end inside a byte */
+        do
+        {
+            uint8_t bitlen = request[transfer->req_ptr++] & JTAG_SEQUENCE_TCK;
 
-        uint8_t bytes = ((bitlen + 7) >> 3);
-    #if (DAP_JTAG != 0)     
-        dap_info.jtag_dev.buf_tms = (info & JTAG_SEQUENCE_TMS) ? 0xFFFFFFFFFFFFFFFF : 0U;
-        rt_memcpy(&dap_info.jtag_dev.buf_tdi, request + transfer->req_ptr, bytes);
-    #endif    
-        transfer->req_ptr += bytes;
-    #if (DAP_JTAG != 0)    
-        dap_jtag_raw(bitlen,
-                     (uint8_t*)&dap_info.jtag_dev.buf_tms,
-                     (uint8_t*)&dap_info.jtag_dev.buf_tdi,
-                     (uint8_t*)&dap_info.jtag_dev.buf_tdo);
+            if (bitlen == 0)
+                bitlen = 64U;
+
+            uint8_t bytes = ((bitlen + 7) >> 3);
+        #if (DAP_JTAG != 0)
+            rt_memcpy(jtag_span_tdi + span_bytes, request + transfer->req_ptr, bytes);
+        #endif
+            span_bits = (span_bytes << 3) + bitlen;
+            span_bytes += bytes;
+            transfer->req_ptr += bytes;
+            transfer->transfer_cnt++;
+            if (bitlen & 0x7)
+                break;
+        } while ((transfer->transfer_cnt < transfer_num) &&
+                 (((request[transfer->req_ptr] ^ info) & (JTAG_SEQUENCE_TMS | JTAG_SEQUENCE_TDO)) == 0));
+
+    #if (DAP_JTAG != 0)
+        dap_jtag_seq(span_bits,
+                     info & JTAG_SEQUENCE_TMS,
+                     jtag_span_tdi,
+                     (info & JTAG_SEQUENCE_TDO) ? (response + transfer->resp_ptr) : jtag_span_tdo);
+    #else
+        (void)span_bits;
     #endif
         if (info & JTAG_SEQUENCE_TDO)
-        {
-        #if (DAP_JTAG != 0)    
-            rt_memcpy(response + transfer->resp_ptr, &dap_info.jtag_dev.buf_tdo, bytes);
-        #endif
-            transfer->resp_ptr += bytes;
-        }
-        transfer->transfer_cnt++;
+            transfer->resp_ptr += span_bytes;
     }
 }
 
+#if (DAP_JTAG != 0)
 /**
- * @brief DAP jtag configure.
+ * @brief Set the JTAG scan chain, devices beyond DAP_JTAG_DEV_CNT are dropped.
  *
- * @param request           A pointer to the request message.
- * @param response          A pointer to the response message.
- * @param transfer          A pointer to the transfer info.
+ * @param ir_length         A pointer to the IR length of each device.
+ * @param count             Num of devices.
  *
  * @return None.
  */
-static void dap_jtag_configure(uint8_t* request, uint8_t* response, dap_transfer_t *transfer)
+static void dap_jtag_chain_set(const uint8_t *ir_length, uint32_t count)
 {
     uint32_t bits = 0;
-    uint32_t count = request[transfer->req_ptr++];
-#if (DAP_JTAG != 0)    
+
     dap_info.jtag_dev.count = MIN(count, DAP_JTAG_DEV_CNT);
-#endif     
-    for (uint32_t n = 0; n < count; n++)
+    for (uint32_t n = 0; n < dap_info.jtag_dev.count; n++)
     {
-        uint32_t length = request[transfer->req_ptr++];
-    #if (DAP_JTAG != 0)    
-        dap_info.jtag_dev.ir_length[n] = length;
+        dap_info.jtag_dev.ir_length[n] = ir_length[n];
         dap_info.jtag_dev.ir_before[n] = bits;
-        bits += length;
-    #endif    
+        bits += ir_length[n];
     }
-    for (uint32_t n = 0; n < count; n++)
+    for (uint32_t n = 0; n < dap_info.jtag_dev.count; n++)
     {
-    #if (DAP_JTAG != 0)    
         bits -= dap_info.jtag_dev.ir_length[n];
         dap_info.jtag_dev.ir_after[n] = bits;
-    #endif     
     }
+    dap_jtag_ir_invalidate();
+    dap_jtag_dr_chain(dap_info.jtag_dev.count);
+    dap_riscv_dtm.valid = false;
+}
+#endif
+
+/**
+ * @brief DAP jtag configure.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param transfer          A pointer to the transfer info.
+ *
+ * @return None.
+ */
+static void dap_jtag_configure(uint8_t* request, uint8_t* response, dap_transfer_t *transfer)
+{
+    uint32_t count = request[transfer->req_ptr++];
+#if (DAP_JTAG != 0)    
+    dap_jtag_chain_set(request + transfer->req_ptr, count);
+#endif     
+    transfer->req_ptr += count;
 #if (DAP_JTAG != 0)    
     response[transfer->resp_ptr++] = DAP_OK;
 #else
@@ -812,6 +989,41 @@ static void dap_jtag_configure(uint8_t* request, uint8_t* response, dap_transfer
 #endif
 }
 
+/**
+ * @brief Detect the JTAG scan chain on the probe, the TAPs are reset.
+ *
+ * @param apply             Configure the chain as JTAG_Configure does when detected.
+ * @param ir_length         A pointer to the IR length of each device, DAP_JTAG_DEV_CNT entries.
+ * @param idcode            A pointer to the IDCODE of each device, DAP_JTAG_DEV_CNT entries.
+ * @param count             A pointer to the num of devices.
+ * @param ir_total          A pointer to the total IR bits of the chain.
+ *
+ * @return JTAG_DETECT_OK or the failed step.
+ */
+uint8_t dap_jtag_chain_detect(uint8_t apply, uint8_t *ir_length, uint32_t *idcode, uint8_t *count, uint16_t *ir_total)
+{
+    *count = 0;
+    *ir_total = 0;
+#if (DAP_JTAG != 0)
+    uint32_t status, devs, bits;
+
+    if (dap_info.port != DAP_PORT_JTAG)
+        return JTAG_DETECT_NO_PORT;
+    if (dap_info.port_io_need_reconfig)
+        port_io_reconfig(dap_info.port);
+
+    dap_jtag_ir_invalidate();
+    status = dap_jtag_detect(DAP_JTAG_DEV_CNT, ir_length, idcode, &devs, &bits);
+    *count = devs;
+    *ir_total = bits;
+    if ((status == JTAG_DETECT_OK) && apply)
+        dap_jtag_chain_set(ir_length, devs);
+    return status;
+#else
+    return JTAG_DETECT_NO_PORT;
+#endif
+}
+
 /**
  * @brief DAP jtag idcode.
  *
@@ -828,23 +1040,11 @@ static void dap_jtag_idcode(uint8_t* request, uint8_t* response, dap_transfer_t
 
     if ((dap_info.port == DAP_PORT_JTAG) && (dap_info.jtag_dev.index < DAP_JTAG_DEV_CNT))
     {
-        dap_jtag_ir(JTAG_IDCODE,
-                    dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                    dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                    dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
-
-        dap_info.jtag_dev.buf_tdi = 0U;
-        dap_info.jtag_dev.buf_tdo = 0U;
-        dap_info.jtag_dev.buf_tms = 1U;
-        uint16_t bitlen = 3 + dap_info.jtag_dev.index + 32;
-        dap_info.jtag_dev.buf_tms |= (0x3 << (bitlen - 1));
-        bitlen += 2;
-        dap_jtag_raw(bitlen,
-                     (uint8_t*)&dap_info.jtag_dev.buf_tms,
-                     (uint8_t*)&dap_info.jtag_dev.buf_tdi,
-                     (uint8_t*)&dap_info.jtag_dev.buf_tdo);
+        dap_jtag_load_ir(JTAG_IDCODE);
+
+        uint32_t idcode = dap_jtag_read_idcode(dap_info.jtag_dev.index);
         response[transfer->resp_ptr++] = DAP_OK;
-        __UNALIGNED_UINT32_WRITE(response + transfer->resp_ptr, (uint32_t)(dap_info.jtag_dev.buf_tdo >> (3 + dap_info.jtag_dev.index)));
+        __UNALIGNED_UINT32_WRITE(response + transfer->resp_ptr, idcode);
         transfer->resp_ptr += 4;
     }
     else
@@ -905,6 +1105,23 @@ static void dap_transfer_configure(uint8_t* request, uint8_t* response, dap_tran
     }
 }
 
+/**
+ * @brief Record DP SELECT written by the host, restored after probe side accesses.
+ *
+ * @param transfer_req      Transfer request.
+ * @param data              A pointer to the write data.
+ *
+ * @return None.
+ */
+static void dap_ap_host_select(uint8_t transfer_req, uint8_t *data)
+{
+    if ((transfer_req & (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | DAP_TRANSFER_A2 | DAP_TRANSFER_A3)) == DP_SELECT)
+    {
+        dap_ap_access.host_select = __UNALIGNED_UINT32_READ(data);
+        dap_ap_access.host_select_valid = true;
+    }
+}
+
 /**
  * @brief DAP swd transfer.
  *
@@ -1079,6 +1296,7 @@ static void dap_swd_transfer(uint8_t* request, uint8_t* response, dap_transfer_t
             {
         #if (DAP_SWD != 0)    
                 transfer->transfer_ack = dap_swd_write(transfer_req, request + transfer->req_ptr);
+                dap_ap_host_select(transfer_req, request + transfer->req_ptr);
                 transfer->req_ptr += 4;
                 if (transfer->transfer_ack != DAP_TRANSFER_OK)
                     break;
@@ -1160,6 +1378,9 @@ static int16_t dap_jtag_transfer(uint8_t* request, uint8_t* response, dap_transf
     uint32_t data = 0; 
     bool post_read = false;
     uint8_t transfer_req = 0, jtag_ir = 0;
+#if (DAP_JTAG != 0)
+    jtag_ir = dap_info.jtag_dev.ir_cur[dap_info.jtag_dev.index];
+#endif
     uint16_t transfer_num = request[transfer->req_ptr++];
     transfer->transfer_cnt = 0;
     transfer->transfer_ack = 0;
@@ -1195,10 +1416,7 @@ static int16_t dap_jtag_transfer(uint8_t* request, uint8_t* response, dap_transf
                     {
                         jtag_ir = JTAG_DPACC;
                 #if (DAP_JTAG != 0)            
-                        dap_jtag_ir(jtag_ir,
-                                    dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                                    dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                                    dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);               
+                        dap_jtag_load_ir(jtag_ir);
                     }
                     transfer->transfer_ack = dap_jtag_dr(DP_RDBUFF | DAP_TRANSFER_RnW,
                                                          0,
@@ -1238,10 +1456,7 @@ static int16_t dap_jtag_transfer(uint8_t* request, uint8_t* response, dap_transf
                 {
                     jtag_ir = request_ir;
             #if (DAP_JTAG != 0)    
-                    dap_jtag_ir(jtag_ir,
-                                dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+                    dap_jtag_load_ir(jtag_ir);
                 }
                 
                 transfer->transfer_ack = dap_jtag_dr(transfer_req,
@@ -1281,10 +1496,7 @@ static int16_t dap_jtag_transfer(uint8_t* request, uint8_t* response, dap_transf
                 {
                     jtag_ir = request_ir;
         #if (DAP_JTAG != 0)        
-                    dap_jtag_ir(jtag_ir,
-                                dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+                    dap_jtag_load_ir(jtag_ir);
                 }
                 transfer->transfer_ack = dap_jtag_dr(transfer_req,
                                                      0,
@@ -1316,10 +1528,7 @@ static int16_t dap_jtag_transfer(uint8_t* request, uint8_t* response, dap_transf
                 {
                     jtag_ir = JTAG_DPACC;
         #if (DAP_JTAG != 0)
-                    dap_jtag_ir(jtag_ir,
-                                dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+                    dap_jtag_load_ir(jtag_ir);
                 }
                 transfer->transfer_ack = dap_jtag_dr(DP_RDBUFF | DAP_TRANSFER_RnW,
                                                      0,
@@ -1349,16 +1558,14 @@ static int16_t dap_jtag_transfer(uint8_t* request, uint8_t* response, dap_transf
                 {
                     jtag_ir = request_ir;
         #if (DAP_JTAG != 0)            
-                    dap_jtag_ir(jtag_ir,
-                                dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+                    dap_jtag_load_ir(jtag_ir);
                 }
                 transfer->transfer_ack = dap_jtag_dr(transfer_req,
                                          __UNALIGNED_UINT32_READ(request + transfer->req_ptr),
                                          dr_before,
                                          dr_after,
                                          (uint8_t *)&data);
+                dap_ap_host_select(transfer_req, request + transfer->req_ptr);
                 transfer->req_ptr += 4;
                 if (transfer->transfer_ack != DAP_TRANSFER_OK)
                     break;        
@@ -1403,10 +1610,7 @@ static int16_t dap_jtag_transfer(uint8_t* request, uint8_t* response, dap_transf
         {
             jtag_ir = JTAG_DPACC;
         #if (DAP_JTAG != 0)
-            dap_jtag_ir(jtag_ir,
-                        dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                        dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                        dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+            dap_jtag_load_ir(jtag_ir);
         }
         transfer->transfer_ack = dap_jtag_dr(DP_RDBUFF | DAP_TRANSFER_RnW,
                                              0,
@@ -1566,10 +1770,7 @@ static int16_t dap_jtag_transfer_block(uint8_t* request, uint8_t* response, dap_
 
     jtag_ir = (transfer_req & DAP_TRANSFER_APnDP) ? JTAG_APACC : JTAG_DPACC;
 #if (DAP_JTAG != 0)    
-    dap_jtag_ir(jtag_ir,
-                dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+    dap_jtag_load_ir(jtag_ir);
 #endif
     if (transfer_req & DAP_TRANSFER_RnW)    
     {
@@ -1587,16 +1788,35 @@ static int16_t dap_jtag_transfer_block(uint8_t* request, uint8_t* response, dap_
     #endif   
         while (transfer->transfer_cnt < transfer_num)
         {
+        #if (DAP_JTAG != 0)
+            if ((transfer_num - transfer->transfer_cnt) > 2)
+            {
+                uint32_t done;
+                uint32_t ack = dap_jtag_dr_train(transfer_req,
+                                                 dr_before,
+                                                 dr_after,
+                                                 transfer_num - transfer->transfer_cnt - 1,
+                                                 response + transfer->resp_ptr,
+                                                 &done);
+                transfer->resp_ptr += done << 2;
+                transfer->transfer_cnt += done;
+                if (ack && (ack != DAP_TRANSFER_OK) && (ack != DAP_TRANSFER_WAIT))
+                {
+                    transfer->transfer_ack = ack;
+                    return 0;
+                }
+                /* nothing done, train not usable or all WAIT, go on with a single scan and its retry */
+                if (done)
+                    continue;
+            }
+        #endif
             if (transfer->transfer_cnt == (transfer_num - 1)) 
             {    
                 if (jtag_ir != JTAG_DPACC)
                 {
                     jtag_ir = JTAG_DPACC;
                 #if (DAP_JTAG != 0)    
-                    dap_jtag_ir(jtag_ir,
-                                dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                                dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+                    dap_jtag_load_ir(jtag_ir);
                 #endif                
                 }   
                 transfer_req = DP_RDBUFF | DAP_TRANSFER_RnW;
@@ -1642,10 +1862,7 @@ static int16_t dap_jtag_transfer_block(uint8_t* request, uint8_t* response, dap_
         {
             jtag_ir = JTAG_DPACC;
     #if (DAP_JTAG != 0)        
-            dap_jtag_ir(jtag_ir,
-                        dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                        dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                        dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+            dap_jtag_load_ir(jtag_ir);
         }
         transfer->transfer_ack = dap_jtag_dr(DP_RDBUFF | DAP_TRANSFER_RnW,
                                              __UNALIGNED_UINT32_READ(request + transfer->req_ptr),
@@ -1712,10 +1929,7 @@ static void dap_write_abort(uint8_t* request, uint8_t* response, dap_transfer_t
                     break;
                 }       
                 dap_info.jtag_dev.index = request[transfer->req_ptr++];
-                dap_jtag_ir(JTAG_ABORT,
-                            dap_info.jtag_dev.ir_length[dap_info.jtag_dev.index],
-                            dap_info.jtag_dev.ir_before[dap_info.jtag_dev.index],
-                            dap_info.jtag_dev.ir_after[dap_info.jtag_dev.index]);
+                dap_jtag_load_ir(JTAG_ABORT);
 
                 uint16_t transfer_ack = dap_jtag_dr(0,
                                                     __UNALIGNED_UINT32_READ(request + transfer->req_ptr),
@@ -1741,6 +1955,768 @@ static void dap_write_abort(uint8_t* request, uint8_t* response, dap_transfer_t
     }
 }
 
+/**
+ * @brief Single DP/AP register transfer on the current port.
+ *
+ * @param transfer_req      Transfer request, APnDP, RnW, A2, A3.
+ * @param data              A pointer to the data, read data is stored here.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t dap_ap_transfer(uint8_t transfer_req, uint32_t *data)
+{
+    uint8_t ack;
+
+    switch (dap_info.port)
+    {
+    #if (DAP_SWD != 0)
+        case DAP_PORT_SWD:
+            {
+                if (transfer_req & DAP_TRANSFER_RnW)
+                    ack = dap_swd_read(transfer_req, (uint8_t *)data);
+                else
+                    ack = dap_swd_write(transfer_req, (uint8_t *)data);
+            }
+            break;
+    #endif
+    #if (DAP_JTAG != 0)
+        case DAP_PORT_JTAG:
+            {
+                uint8_t request_ir = (transfer_req & DAP_TRANSFER_APnDP) ? JTAG_APACC : JTAG_DPACC;
+                uint32_t dummy;
+
+                if (dap_info.jtag_dev.index >= dap_info.jtag_dev.count)
+                {
+                    ack = DAP_TRANSFER_ERROR;
+                    break;
+                }
+                dap_jtag_load_ir(request_ir);
+                ack = dap_jtag_dr(transfer_req,
+                                  (transfer_req & DAP_TRANSFER_RnW) ? 0 : *data,
+                                  dap_info.jtag_dev.index,
+                                  dap_info.jtag_dev.count - dap_info.jtag_dev.index - 1,
+                                  (transfer_req & DAP_TRANSFER_RnW) ? (uint8_t *)data : (uint8_t *)&dummy);
+            }
+            break;
+    #endif
+        default:
+            ack = DAP_TRANSFER_ERROR;
+            break;
+    }
+
+    if (ack != DAP_TRANSFER_OK)
+        dap_ap_access.error = true;
+    return ack;
+}
+
+/**
+ * @brief Select the AP register bank of the session AP.
+ *
+ * @param ap                AP num.
+ * @param addr              AP register address.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t dap_ap_select(uint8_t ap, uint8_t addr)
+{
+    uint32_t select = ((uint32_t)ap << 24) | (addr & 0xF0U);
+    uint8_t ack = DAP_TRANSFER_OK;
+
+    if (dap_ap_access.select != select)
+    {
+        ack = dap_ap_transfer(DP_SELECT, &select);
+        dap_ap_access.select = (ack == DAP_TRANSFER_OK) ? select : 0xFFFFFFFFU;
+    }
+    return ack;
+}
+
+/**
+ * @brief Read an AP register of the session AP, the posted read is completed by DP RDBUFF.
+ *
+ * @param addr              AP register address.
+ * @param data              A pointer to the read data.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_ap_read(uint8_t addr, uint32_t *data)
+{
+    uint8_t ack;
+    uint32_t dummy;
+
+    ack = dap_ap_select(dap_ap_access.ap, addr);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = dap_ap_transfer(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | (addr & 0x0CU), &dummy);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    return dap_ap_transfer(DP_RDBUFF | DAP_TRANSFER_RnW, data);
+}
+
+/**
+ * @brief Write an AP register of the session AP, the write is checked by DP RDBUFF.
+ *
+ * @param addr              AP register address.
+ * @param data              Write data.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_ap_write(uint8_t addr, uint32_t data)
+{
+    uint8_t ack;
+    uint32_t dummy;
+
+    ack = dap_ap_select(dap_ap_access.ap, addr);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = dap_ap_transfer(DAP_TRANSFER_APnDP | (addr & 0x0CU), &data);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    return dap_ap_transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &dummy);
+}
+
+/**
+ * @brief Read a DP register in the session, the JTAG DPACC read is posted and
+ *        completed by DP RDBUFF, the SWD read is not.
+ *
+ * @param addr              DP register address.
+ * @param data              A pointer to the read data.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_dp_read(uint8_t addr, uint32_t *data)
+{
+    uint8_t ack;
+
+    ack = dap_ap_transfer(DAP_TRANSFER_RnW | (addr & 0x0CU), data);
+#if (DAP_JTAG != 0)
+    if ((ack == DAP_TRANSFER_OK) && (dap_info.port == DAP_PORT_JTAG))
+        ack = dap_ap_transfer(DP_RDBUFF | DAP_TRANSFER_RnW, data);
+#endif
+    return ack;
+}
+
+/**
+ * @brief Set size and address increment of the session CSW, written only when changed.
+ *
+ * @param mode              CSW size and address increment bits.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t dap_ap_csw(uint32_t mode)
+{
+    uint32_t csw = (dap_ap_access.csw & ~(CSW_SIZE | CSW_ADDRINC)) | mode;
+    uint8_t ack = DAP_TRANSFER_OK;
+
+    if (dap_ap_access.cur_csw != csw)
+    {
+        ack = dap_ap_write(AP_CSW, csw);
+        dap_ap_access.cur_csw = (ack == DAP_TRANSFER_OK) ? csw : 0xFFFFFFFFU;
+    }
+    return ack;
+}
+
+/**
+ * @brief Read a target word through the session MEM-AP.
+ *
+ * @param addr              Target address.
+ * @param data              A pointer to the read data.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_mem_read32(uint32_t addr, uint32_t *data)
+{
+    uint8_t ack = dap_ap_csw(CSW_SIZE32);
+
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_write(AP_TAR, addr);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    return dap_ap_read(AP_DRW, data);
+}
+
+/**
+ * @brief Write a target word through the session MEM-AP.
+ *
+ * @param addr              Target address.
+ * @param data              Write data.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_mem_write32(uint32_t addr, uint32_t data)
+{
+    uint8_t ack = dap_ap_csw(CSW_SIZE32);
+
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_write(AP_TAR, addr);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    return dap_ap_write(AP_DRW, data);
+}
+
+/**
+ * @brief Read target words through the session MEM-AP with address increment,
+ *        DRW reads are pipelined and TAR is rewritten at every 1KB boundary.
+ *
+ * @param addr              Target address, word aligned.
+ * @param data              A pointer to the read data.
+ * @param cnt               Num of words.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_mem_read_block(uint32_t addr, uint32_t *data, uint32_t cnt)
+{
+    uint32_t num, dummy;
+    uint8_t ack = dap_ap_csw(CSW_SIZE32 | CSW_SADDRINC);
+
+    while ((ack == DAP_TRANSFER_OK) && cnt)
+    {
+        num = MIN(cnt, (0x400U - (addr & 0x3FFU)) >> 2);
+        ack = dap_ap_write(AP_TAR, addr);
+        if (ack == DAP_TRANSFER_OK)
+            ack = dap_ap_transfer(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_DRW, &dummy);
+        for (uint32_t i = 1; (i < num) && (ack == DAP_TRANSFER_OK); i++)
+            ack = dap_ap_transfer(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_DRW, data + i - 1);
+        if (ack == DAP_TRANSFER_OK)
+            ack = dap_ap_transfer(DP_RDBUFF | DAP_TRANSFER_RnW, data + num - 1);
+        addr += num << 2;
+        data += num;
+        cnt -= num;
+    }
+    return ack;
+}
+
+/**
+ * @brief Write target words through the session MEM-AP with address increment,
+ *        TAR is rewritten at every 1KB boundary and the last write is checked by DP RDBUFF.
+ *
+ * @param addr              Target address, word aligned.
+ * @param data              A pointer to the write data, no alignment needed.
+ * @param cnt               Num of words.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_mem_write_block(uint32_t addr, const uint8_t *data, uint32_t cnt)
+{
+    uint32_t num, word;
+    uint8_t ack = dap_ap_csw(CSW_SIZE32 | CSW_SADDRINC);
+
+    while ((ack == DAP_TRANSFER_OK) && cnt)
+    {
+        num = MIN(cnt, (0x400U - (addr & 0x3FFU)) >> 2);
+        ack = dap_ap_write(AP_TAR, addr);
+        for (uint32_t i = 0; (i < num) && (ack == DAP_TRANSFER_OK); i++)
+        {
+            word = __UNALIGNED_UINT32_READ(data + (i << 2));
+            ack = dap_ap_transfer(DAP_TRANSFER_APnDP | AP_DRW, &word);
+        }
+        addr += num << 2;
+        data += num << 2;
+        cnt -= num;
+    }
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &word);
+    return ack;
+}
+
+/**
+ * @brief Write target bytes through the session MEM-AP with byte access and address increment,
+ *        each byte is placed on its lane, the last write is checked by DP RDBUFF.
+ *
+ * @param addr              Target address, no alignment needed.
+ * @param data              A pointer to the write data.
+ * @param cnt               Num of bytes.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_mem_write_bytes(uint32_t addr, const uint8_t *data, uint32_t cnt)
+{
+    uint32_t word;
+    uint8_t ack = dap_ap_csw(CSW_SIZE8 | CSW_SADDRINC);
+
+    if ((ack == DAP_TRANSFER_OK) && cnt)
+        ack = dap_ap_write(AP_TAR, addr);
+    for (uint32_t i = 0; (i < cnt) && (ack == DAP_TRANSFER_OK); i++, addr++)
+    {
+        /* address increment wraps inside 1KB */
+        if (i && !(addr & 0x3FFU))
+            ack = dap_ap_write(AP_TAR, addr);
+        word = (uint32_t)data[i] << ((addr & 0x03U) << 3);
+        if (ack == DAP_TRANSFER_OK)
+            ack = dap_ap_transfer(DAP_TRANSFER_APnDP | AP_DRW, &word);
+    }
+    if ((ack == DAP_TRANSFER_OK) && cnt)
+        ack = dap_ap_transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &word);
+    return ack;
+}
+
+/**
+ * @brief Open a probe side AP access session without touching CSW, for APs of any class.
+ *
+ * @param ap                AP num.
+ *
+ * @return DAP_TRANSFER_OK, DAP_TRANSFER_ERROR if no port is connected.
+ */
+uint8_t dap_ap_open(uint8_t ap)
+{
+    if ((dap_info.port != DAP_PORT_SWD) && (dap_info.port != DAP_PORT_JTAG))
+        return DAP_TRANSFER_ERROR;
+
+    dap_ap_access.active = true;
+    dap_ap_access.saved = false;
+    dap_ap_access.ap = ap;
+    dap_ap_access.error = false;
+    dap_ap_access.select = 0xFFFFFFFFU;
+    dap_ap_access.cur_csw = 0xFFFFFFFFU;
+    return DAP_TRANSFER_OK;
+}
+
+/**
+ * @brief Open a probe side MEM-AP access session, save CSW and TAR of the host,
+ *        and set CSW to 32-bit single accesses.
+ *
+ * @param ap                AP num.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_ap_begin(uint8_t ap)
+{
+    uint8_t ack = dap_ap_open(ap);
+
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    ack = dap_ap_read(AP_CSW, &dap_ap_access.csw);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_read(AP_TAR, &dap_ap_access.tar);
+    if (ack == DAP_TRANSFER_OK)
+    {
+        dap_ap_access.saved = true;
+        ack = dap_ap_csw(CSW_SIZE32);
+    }
+    return ack;
+}
+
+/**
+ * @brief Close the probe side MEM-AP access session, restore CSW, TAR and DP SELECT of the host,
+ *        sticky errors caused by the session are cleared.
+ *
+ * @return None.
+ */
+void dap_ap_end(void)
+{
+    if (!dap_ap_access.active)
+        return;
+
+    if (dap_ap_access.error)
+    {
+        uint32_t abort = DP_ABORT_CLR_STICKY;
+
+    #if (DAP_SWD != 0)
+        if (dap_info.port == DAP_PORT_SWD)
+            dap_swd_write(DP_ABORT, (uint8_t *)&abort);
+    #endif
+    #if (DAP_JTAG != 0)
+        if ((dap_info.port == DAP_PORT_JTAG) && (dap_info.jtag_dev.index < dap_info.jtag_dev.count))
+        {
+            dap_jtag_load_ir(JTAG_ABORT);
+            dap_jtag_dr(0, abort, dap_info.jtag_dev.index,
+                        dap_info.jtag_dev.count - dap_info.jtag_dev.index - 1, NULL);
+        }
+    #endif
+        dap_ap_access.select = 0xFFFFFFFFU;
+    }
+
+    if (dap_ap_access.saved)
+    {
+        dap_ap_write(AP_CSW, dap_ap_access.csw);
+        dap_ap_write(AP_TAR, dap_ap_access.tar);
+    }
+
+    if (dap_ap_access.host_select_valid && (dap_ap_access.select != dap_ap_access.host_select))
+        dap_ap_transfer(DP_SELECT, &dap_ap_access.host_select);
+    dap_ap_access.active = false;
+}
+
+#if (DAP_SWD != 0)
+/**
+ * @brief Set the SWD multi-drop target table, no target is selected afterwards.
+ *
+ * @param targetsel         A pointer to the TARGETSEL values, no alignment needed.
+ * @param count             Num of targets.
+ *
+ * @return DAP_OK or DAP_ERROR.
+ */
+uint8_t dap_swd_target_config(const uint8_t *targetsel, uint8_t count)
+{
+    if (count > DAP_SWD_TARGET_CNT)
+        return DAP_ERROR;
+
+    rt_memset(&dap_swd_target, 0, sizeof(dap_swd_target_t));
+    dap_swd_target.count = count;
+    dap_swd_target.current = DAP_SWD_TARGET_NONE;
+    for (uint32_t i = 0; i < count; i++)
+        dap_swd_target.targetsel[i] = __UNALIGNED_UINT32_READ(targetsel + (i << 2));
+    return DAP_OK;
+}
+
+/**
+ * @brief Switch to a SWD multi-drop target. The wire sequence is only sent when the target
+ *        is not selected yet, DP SELECT of the host is saved and restored per target.
+ *
+ * @param index             Target index in the table.
+ * @param dpidr             A pointer to the DPIDR of the target.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_swd_target_switch(uint8_t index, uint32_t *dpidr)
+{
+    uint8_t ack;
+
+    if ((dap_info.port != DAP_PORT_SWD) || (index >= dap_swd_target.count))
+        return DAP_TRANSFER_ERROR;
+    if (index == dap_swd_target.current)
+    {
+        *dpidr = dap_swd_target.dpidr[index];
+        return DAP_TRANSFER_OK;
+    }
+
+    if (dap_swd_target.current != DAP_SWD_TARGET_NONE)
+    {
+        dap_swd_target.host_select[dap_swd_target.current] = dap_ap_access.host_select;
+        dap_swd_target.host_select_valid[dap_swd_target.current] = dap_ap_access.host_select_valid;
+    }
+
+    if (dap_info.port_io_need_reconfig)
+        port_io_reconfig(dap_info.port);
+    ack = dap_swd_targetsel(dap_swd_target.targetsel[index], (uint8_t *)dpidr);
+    if (ack == DAP_TRANSFER_OK)
+    {
+        dap_swd_target.current = index;
+        dap_swd_target.dpidr[index] = *dpidr;
+        dap_ap_access.host_select = dap_swd_target.host_select[index];
+        dap_ap_access.host_select_valid = dap_swd_target.host_select_valid[index];
+    }
+    else
+    {
+        dap_swd_target.current = DAP_SWD_TARGET_NONE;
+        dap_ap_access.host_select_valid = false;
+    }
+    dap_vendor_topology_reset();
+    return ack;
+}
+#endif
+
+/**
+ * @brief Load an IR of any value into a JTAG device for probe side scans, the other
+ *        devices are put into BYPASS.
+ *
+ * @param index             JTAG device index.
+ * @param ir                IR value.
+ *
+ * @return DAP_TRANSFER_OK, DAP_TRANSFER_ERROR if the device is not on the chain.
+ */
+uint8_t dap_jtag_dev_ir(uint8_t index, uint32_t ir)
+{
+#if (DAP_JTAG != 0)
+    if ((dap_info.port != DAP_PORT_JTAG) || (index >= dap_info.jtag_dev.count))
+        return DAP_TRANSFER_ERROR;
+    if (dap_info.port_io_need_reconfig)
+        port_io_reconfig(dap_info.port);
+
+    dap_jtag_ir(ir,
+                dap_info.jtag_dev.ir_length[index],
+                dap_info.jtag_dev.ir_before[index],
+                dap_info.jtag_dev.ir_after[index]);
+    /* the IR may be wider than the cache keeps */
+    dap_jtag_ir_invalidate();
+    return DAP_TRANSFER_OK;
+#else
+    return DAP_TRANSFER_ERROR;
+#endif
+}
+
+/**
+ * @brief DR scan of any length through a JTAG device, the IR is loaded by dap_jtag_dev_ir.
+ *
+ * @param index             JTAG device index.
+ * @param bitlen            Len of DR value, not 0.
+ * @param tdi               A pointer to the tdi data, (bitlen + 7) / 8 bytes.
+ * @param tdo               A pointer to the tdo data, (bitlen + 7) / 8 bytes.
+ *
+ * @return DAP_TRANSFER_OK, DAP_TRANSFER_ERROR if the device is not on the chain.
+ */
+uint8_t dap_jtag_dev_dr(uint8_t index, uint32_t bitlen, uint8_t *tdi, uint8_t *tdo)
+{
+#if (DAP_JTAG != 0)
+    if ((dap_info.port != DAP_PORT_JTAG) || (index >= dap_info.jtag_dev.count) || !bitlen)
+        return DAP_TRANSFER_ERROR;
+
+    dap_jtag_dr_bits(bitlen, index, dap_info.jtag_dev.count - index - 1, tdi, tdo);
+    return DAP_TRANSFER_OK;
+#else
+    return DAP_TRANSFER_ERROR;
+#endif
+}
+
+/**
+ * @brief Prepare raw TAP access of the whole chain, the loaded IR is no longer known
+ *        and the TAP has to be back in Run-Test/Idle before other JTAG commands.
+ *
+ * @return DAP_TRANSFER_OK, DAP_TRANSFER_ERROR if the port is not JTAG.
+ */
+uint8_t dap_jtag_tap_begin(void)
+{
+#if (DAP_JTAG != 0)
+    if (dap_info.port != DAP_PORT_JTAG)
+        return DAP_TRANSFER_ERROR;
+    if (dap_info.port_io_need_reconfig)
+        port_io_reconfig(dap_info.port);
+
+    dap_jtag_ir_invalidate();
+    return DAP_TRANSFER_OK;
+#else
+    return DAP_TRANSFER_ERROR;
+#endif
+}
+
+#if (DAP_JTAG != 0)
+/**
+ * @brief RISC-V scan DTMCS of the DTM device.
+ *
+ * @param dtmcs             DTMCS value written.
+ *
+ * @return DTMCS value captured.
+ */
+static uint32_t dap_riscv_dtmcs(uint32_t dtmcs)
+{
+    uint8_t index = dap_info.jtag_dev.index;
+
+    dap_jtag_load_ir(RISCV_IR_DTMCS);
+    return (uint32_t)dap_jtag_dr_scan(dtmcs, 32, index, dap_info.jtag_dev.count - index - 1, 0);
+}
+
+/**
+ * @brief RISC-V scan DMI, the scan returns the result of the previous DMI operation.
+ *
+ * @param op                Operation, RISCV_DMI_NOP / READ / WRITE.
+ * @param addr              DMI address.
+ * @param data              Data written.
+ * @param rdata             A pointer to the data read by the previous operation, NULL to discard.
+ *
+ * @return Result of the previous operation.
+ */
+static uint32_t dap_riscv_dmi_scan(uint32_t op, uint32_t addr, uint32_t data, uint32_t *rdata)
+{
+    uint8_t index = dap_info.jtag_dev.index;
+    uint64_t dr;
+
+    dap_jtag_load_ir(RISCV_IR_DMI);
+    dr = ((uint64_t)addr << 34) | ((uint64_t)data << 2) | op;
+    dr = dap_jtag_dr_scan(dr, dap_riscv_dtm.abits + 34U, index, dap_info.jtag_dev.count - index - 1, dap_riscv_dtm.idle);
+    if (rdata)
+        *rdata = (uint32_t)(dr >> 2);
+    return (uint32_t)dr & RISCV_DMI_OP;
+}
+
+/**
+ * @brief RISC-V clear the sticky DMI error, a busy DMI gets more idle cycles per scan.
+ *
+ * @param status            Result of the failed operation.
+ *
+ * @return Ack of transfer, DAP_TRANSFER_WAIT : busy, DAP_TRANSFER_FAULT : failed.
+ */
+static uint8_t dap_riscv_dmi_recover(uint32_t status)
+{
+    dap_riscv_dtmcs(RISCV_DTMCS_DMIRESET);
+    if (status != RISCV_DMI_BUSY)
+        return DAP_TRANSFER_FAULT;
+    dap_riscv_dtm_backoff();
+    return DAP_TRANSFER_WAIT;
+}
+
+/**
+ * @brief RISC-V check the DTM is selected and make its device the current JTAG device.
+ *
+ * @return Ack of transfer, DAP_TRANSFER_ERROR if no DTM is selected.
+ */
+static uint8_t dap_riscv_dmi_begin(void)
+{
+    if ((dap_info.port != DAP_PORT_JTAG) || !dap_riscv_dtm.valid)
+        return DAP_TRANSFER_ERROR;
+    if (dap_info.port_io_need_reconfig)
+        port_io_reconfig(dap_info.port);
+    dap_info.jtag_dev.index = dap_riscv_dtm.index;
+    return DAP_TRANSFER_OK;
+}
+
+/**
+ * @brief RISC-V select the DTM of a JTAG device, DMI address bits and idle cycles are taken
+ *        from DTMCS and the sticky DMI error is cleared.
+ *
+ * @param index             JTAG device index.
+ * @param hard_reset        Write dtmcs.dmihardreset first.
+ * @param dtmcs             A pointer to the DTMCS value.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_riscv_dtm_select(uint8_t index, uint8_t hard_reset, uint32_t *dtmcs)
+{
+    uint32_t abits;
+
+    *dtmcs = 0;
+    dap_riscv_dtm.valid = false;
+    if ((dap_info.port != DAP_PORT_JTAG) || (index >= dap_info.jtag_dev.count))
+        return DAP_TRANSFER_ERROR;
+    if (dap_info.port_io_need_reconfig)
+        port_io_reconfig(dap_info.port);
+
+    dap_info.jtag_dev.index = index;
+    if (hard_reset)
+        dap_riscv_dtmcs(RISCV_DTMCS_DMIHARDRESET);
+    *dtmcs = dap_riscv_dtmcs(RISCV_DTMCS_DMIRESET);
+
+    /* 0.13 and 1.0 debug spec, the DMI scan has to fit 64 bits */
+    abits = RISCV_DTMCS_ABITS(*dtmcs);
+    if ((RISCV_DTMCS_VERSION(*dtmcs) != RISCV_DTMCS_VERSION_013) || !abits || ((abits + 34U) > 64U))
+        return DAP_TRANSFER_ERROR;
+
+    dap_riscv_dtm.index = index;
+    dap_riscv_dtm.abits = abits;
+    /* idle hint 1 only asks to pass Run-Test/Idle, which every scan does */
+    dap_riscv_dtm.idle = RISCV_DTMCS_IDLE(*dtmcs) ? (RISCV_DTMCS_IDLE(*dtmcs) - 1) : 0;
+    dap_riscv_dtm.valid = true;
+    dap_riscv_dmi_scan(RISCV_DMI_NOP, 0, 0, NULL);
+    return DAP_TRANSFER_OK;
+}
+
+/**
+ * @brief RISC-V give the DMI more idle cycles per scan after a busy result.
+ *
+ * @return None.
+ */
+void dap_riscv_dtm_backoff(void)
+{
+    uint32_t idle = dap_riscv_dtm.idle + (dap_riscv_dtm.idle >> 2) + 1U;
+
+    dap_riscv_dtm.idle = MIN(idle, RISCV_DMI_IDLE_MAX);
+}
+
+/**
+ * @brief RISC-V DMI access, busy results are cleared and retried with more idle cycles.
+ *
+ * @param op                Operation, RISCV_DMI_READ / WRITE.
+ * @param addr              DMI address.
+ * @param data              Data written.
+ * @param rdata             A pointer to the data read, NULL to discard.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t dap_riscv_dmi_access(uint32_t op, uint32_t addr, uint32_t data, uint32_t *rdata)
+{
+    uint32_t status, retry = 0;
+    uint8_t ack = dap_riscv_dmi_begin();
+
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    do
+    {
+        status = dap_riscv_dmi_scan(op, addr, data, NULL);
+        if (status == RISCV_DMI_SUCCESS)
+            status = dap_riscv_dmi_scan(RISCV_DMI_NOP, 0, 0, rdata);
+        if (status == RISCV_DMI_SUCCESS)
+            return DAP_TRANSFER_OK;
+        ack = dap_riscv_dmi_recover(status);
+    } while ((ack == DAP_TRANSFER_WAIT) && (retry++ < dap_info.transfer.retry_count));
+    return ack;
+}
+
+/**
+ * @brief RISC-V DMI read.
+ *
+ * @param addr              DMI address.
+ * @param data              A pointer to the data read.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_riscv_dmi_read(uint32_t addr, uint32_t *data)
+{
+    return dap_riscv_dmi_access(RISCV_DMI_READ, addr, 0, data);
+}
+
+/**
+ * @brief RISC-V DMI write.
+ *
+ * @param addr              DMI address.
+ * @param data              Data written.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_riscv_dmi_write(uint32_t addr, uint32_t data)
+{
+    return dap_riscv_dmi_access(RISCV_DMI_WRITE, addr, data, NULL);
+}
+
+/**
+ * @brief RISC-V read a DMI register repeatedly, each scan returns the data of the previous
+ *        read. Not retried on busy since the reads may have side effects, the DMI is
+ *        recovered and the caller restarts the sequence.
+ *
+ * @param addr              DMI address.
+ * @param data              A pointer to the data read, no alignment needed.
+ * @param cnt               Num of reads.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_riscv_dmi_read_repeat(uint32_t addr, uint8_t *data, uint32_t cnt)
+{
+    uint32_t status, rdata;
+    uint8_t ack = dap_riscv_dmi_begin();
+
+    if ((ack != DAP_TRANSFER_OK) || !cnt)
+        return ack;
+
+    status = dap_riscv_dmi_scan(RISCV_DMI_READ, addr, 0, NULL);
+    for (uint32_t n = 1; (status == RISCV_DMI_SUCCESS) && (n <= cnt); n++)
+    {
+        status = dap_riscv_dmi_scan((n < cnt) ? RISCV_DMI_READ : RISCV_DMI_NOP, addr, 0, &rdata);
+        __UNALIGNED_UINT32_WRITE(data, rdata);
+        data += 4;
+    }
+    if (status != RISCV_DMI_SUCCESS)
+        return dap_riscv_dmi_recover(status);
+    return DAP_TRANSFER_OK;
+}
+
+/**
+ * @brief RISC-V write a DMI register repeatedly, each scan returns the result of the
+ *        previous write. Not retried on busy as dap_riscv_dmi_read_repeat.
+ *
+ * @param addr              DMI address.
+ * @param data              A pointer to the data written, no alignment needed.
+ * @param cnt               Num of writes.
+ *
+ * @return Ack of transfer.
+ */
+uint8_t dap_riscv_dmi_write_repeat(uint32_t addr, const uint8_t *data, uint32_t cnt)
+{
+    uint32_t status = RISCV_DMI_SUCCESS;
+    uint8_t ack = dap_riscv_dmi_begin();
+
+    if ((ack != DAP_TRANSFER_OK) || !cnt)
+        return ack;
+
+    for (uint32_t n = 0; (status == RISCV_DMI_SUCCESS) && (n < cnt); n++)
+    {
+        status = dap_riscv_dmi_scan(RISCV_DMI_WRITE, addr, __UNALIGNED_UINT32_READ(data), NULL);
+        data += 4;
+    }
+    if (status == RISCV_DMI_SUCCESS)
+        status = dap_riscv_dmi_scan(RISCV_DMI_NOP, 0, 0, NULL);
+    if (status != RISCV_DMI_SUCCESS)
+        return dap_riscv_dmi_recover(status);
+    return DAP_TRANSFER_OK;
+}
+#endif
+
 dap_transfer_t dap_transfer;
 
 /**
@@ -1899,6 +2875,7 @@ uint16_t dap_request_handler(uint8_t* request, uint8_t* response, uint16_t pkt_s
                                 dap_dummy_transfer(request, response, &dap_transfer);
                                 break;
                             }    
+                            dap_jtag_ack_check(dap_transfer.transfer_ack);
                         }
                         else
                         {
@@ -1926,6 +2903,7 @@ uint16_t dap_request_handler(uint8_t* request, uint8_t* response, uint16_t pkt_s
                                 response[resp_start + 2] = 0;
                                 break;
                             }
+                            dap_jtag_ack_check(dap_transfer.transfer_ack);
                         }
                         else
                         {
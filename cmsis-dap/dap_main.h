@@ -182,6 +182,32 @@
 #define DP_RESEND                       0x08U   // Resend (SW Read Only)
 #define DP_RDBUFF                       0x0CU   // Read Buffer (Read Only)
 
+// DP IDR version, DPv3 is the ADIv6 debug port
+#define DP_IDR_VERSION(idr)             (((idr) >> 12) & 0x0FU)
+#define DP_IDR_VERSION_ADIV6            3U
+
+// DP ABORT clear STKCMP, STKERR, WDERR and ORUNERR
+#define DP_ABORT_CLR_STICKY             0x1EU
+#define DAP_SWD_TARGET_NONE             0xFFU
+
+// MEM-AP Register Addresses
+#define AP_CSW                          0x00U   // Control & Status Word
+#define AP_TAR                          0x04U   // Transfer Address
+#define AP_DRW                          0x0CU   // Data Read/Write
+#define AP_BD0                          0x10U   // Banked Data 0
+#define AP_BD1                          0x14U   // Banked Data 1
+#define AP_BD2                          0x18U   // Banked Data 2
+#define AP_BD3                          0x1CU   // Banked Data 3
+#define AP_BASE                         0xF8U   // Debug Base Address
+#define AP_IDR                          0xFCU   // Identification Register
+
+// MEM-AP CSW
+#define CSW_SIZE                        0x07U   // Access size mask
+#define CSW_SIZE8                       0x00U   // Byte access
+#define CSW_SIZE32                      0x02U   // Word access
+#define CSW_ADDRINC                     0x30U   // Address increment mask
+#define CSW_SADDRINC                    0x10U   // Single address increment
+
 // JTAG IR Codes
 #define JTAG_ABORT                      0x08U
 #define JTAG_DPACC                      0x0AU
@@ -189,6 +215,35 @@
 #define JTAG_IDCODE                     0x0EU
 #define JTAG_BYPASS                     0x0FU
 
+// RISC-V DTM IR Codes
+#define RISCV_IR_DTMCS                  0x10U
+#define RISCV_IR_DMI                    0x11U
+// RISC-V DTMCS
+#define RISCV_DTMCS_VERSION(x)          ((x) & 0x0FU)
+#define RISCV_DTMCS_VERSION_013         0x01U   // Debug spec 0.13 and 1.0
+#define RISCV_DTMCS_ABITS(x)            (((x) >> 4) & 0x3FU)
+#define RISCV_DTMCS_IDLE(x)             (((x) >> 12) & 0x07U)
+#define RISCV_DTMCS_DMIRESET            (1U << 16)
+#define RISCV_DTMCS_DMIHARDRESET        (1U << 17)
+// RISC-V DMI op and result
+#define RISCV_DMI_OP                    0x03U
+#define RISCV_DMI_NOP                   0x00U
+#define RISCV_DMI_READ                  0x01U
+#define RISCV_DMI_WRITE                 0x02U
+#define RISCV_DMI_SUCCESS               0x00U
+#define RISCV_DMI_FAILED                0x02U
+#define RISCV_DMI_BUSY                  0x03U
+#define RISCV_DMI_IDLE_MAX              255U    // Max Run-Test/Idle cycles after a DMI scan
+// JTAG chain detection status
+#define JTAG_DETECT_OK                  0x00U   // Chain detected
+#define JTAG_DETECT_NO_PORT             0x01U   // JTAG port is not connected
+#define JTAG_DETECT_NO_CHAIN            0x02U   // No device between TDI and TDO
+#define JTAG_DETECT_IR_TOO_LONG         0x03U   // IR chain longer than the probe measures
+#define JTAG_DETECT_TOO_MANY            0x04U   // More devices than DAP_JTAG_DEV_CNT
+#define JTAG_DETECT_IR_AMBIGUOUS        0x05U   // IR capture patterns do not split into the devices
+#define JTAG_DETECT_TDO_LOW             0x06U   // TDO stuck at 0
+#define JTAG_DETECT_TDO_HIGH            0x07U   // TDO stuck at 1
+
 // JTAG Sequence Info
 #define JTAG_SEQUENCE_TCK               0x3FU   // TCK count
 #define JTAG_SEQUENCE_TMS               0x40U   // TMS value
@@ -207,6 +262,30 @@ extern "C" {
 extern void dap_do_abort(void);
 extern void dap_init(void);
 extern uint16_t dap_request_handler(uint8_t* request, uint8_t* response, uint16_t pkt_size);
+extern uint8_t dap_ap_open(uint8_t ap);
+extern uint8_t dap_ap_begin(uint8_t ap);
+extern void dap_ap_end(void);
+extern uint8_t dap_ap_read(uint8_t addr, uint32_t *data);
+extern uint8_t dap_ap_write(uint8_t addr, uint32_t data);
+extern uint8_t dap_dp_read(uint8_t addr, uint32_t *data);
+extern uint8_t dap_mem_read32(uint32_t addr, uint32_t *data);
+extern uint8_t dap_mem_write32(uint32_t addr, uint32_t data);
+extern uint8_t dap_mem_read_block(uint32_t addr, uint32_t *data, uint32_t cnt);
+extern uint8_t dap_mem_write_block(uint32_t addr, const uint8_t *data, uint32_t cnt);
+extern uint8_t dap_mem_write_bytes(uint32_t addr, const uint8_t *data, uint32_t cnt);
+extern uint8_t dap_swd_target_config(const uint8_t *targetsel, uint8_t count);
+extern uint8_t dap_swd_target_switch(uint8_t index, uint32_t *dpidr);
+extern void dap_jtag_ir_invalidate(void);
+extern uint8_t dap_jtag_chain_detect(uint8_t apply, uint8_t *ir_length, uint32_t *idcode, uint8_t *count, uint16_t *ir_total);
+extern uint8_t dap_jtag_dev_ir(uint8_t index, uint32_t ir);
+extern uint8_t dap_jtag_dev_dr(uint8_t index, uint32_t bitlen, uint8_t *tdi, uint8_t *tdo);
+extern uint8_t dap_jtag_tap_begin(void);
+extern uint8_t dap_riscv_dtm_select(uint8_t index, uint8_t hard_reset, uint32_t *dtmcs);
+extern void dap_riscv_dtm_backoff(void);
+extern uint8_t dap_riscv_dmi_read(uint32_t addr, uint32_t *data);
+extern uint8_t dap_riscv_dmi_write(uint32_t addr, uint32_t data);
+extern uint8_t dap_riscv_dmi_read_repeat(uint32_t addr, uint8_t *data, uint32_t cnt);
+extern uint8_t dap_riscv_dmi_write_repeat(uint32_t addr, const uint8_t *data, uint32_t cnt);
 
 #ifdef __cplusplus
 }
@@ -6,15 +6,2810 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-12     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       add thread statistics command.
+ * 2026-10-18     SecondHandCoder       add PC sampling profiler.
+ * 2026-10-18     SecondHandCoder       add halt watcher.
+ * 2026-10-18     SecondHandCoder       add batched core register access.
+ * 2026-10-18     SecondHandCoder       add target memory CRC.
+ * 2026-10-18     SecondHandCoder       add block compare.
+ * 2026-10-18     SecondHandCoder       add flash algorithm runner.
+ * 2026-10-18     SecondHandCoder       add RTT streamer.
+ * 2026-10-18     SecondHandCoder       add periodic variable sampling.
+ * 2026-10-18     SecondHandCoder       add AP and ROM table discovery cache.
+ * 2026-10-18     SecondHandCoder       add SWD multi-drop target commands.
+ * 2026-10-18     SecondHandCoder       add JTAG scan chain detection.
+ * 2026-10-18     SecondHandCoder       add RISC-V DMI, register and memory access.
+ * 2026-10-18     SecondHandCoder       add boundary scan sampling stream.
+ * 2026-10-18     SecondHandCoder       add SVF/XSVF player.
  */
 
 #include "dap_vendor.h"
 #include "dap_main.h"
 #include "ch32f205_backup.h"
+#include "ch32f205_rt_thread.h"
+#include "ch32f205_time.h"
+#include "ch32f205_clk.h"
+#include "ch32f205_crc.h"
+#include "ch32f205_dap_config.h"
+#include "ch32f205_dap.h"
 #include "ch32f20x.h"
+#include "jtag.h"
 
 
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+// thread statistics response: status, total, count, uptime
+#define THREAD_STAT_HEAD_SIZE           11U
+// thread statistics entry: name, priority, stack size, stack used, switches, cycles
+#define THREAD_STAT_ENTRY_SIZE          (RT_NAME_MAX + 17U)
+
+// PC sampling commands
+#define PC_SAMPLE_START                 0x00U
+#define PC_SAMPLE_STOP                  0x01U
+#define PC_SAMPLE_FETCH                 0x02U
+// PC sampling histogram buckets
+#define PC_SAMPLE_BUCKET_NUM            256U
+// PC sampling fetch response: status, active, samples, out of range, no pc, errors, bucket num, start, count
+#define PC_SAMPLE_HEAD_SIZE             24U
+// max time of one sampling burst, the rest of the tick is left to other threads
+#define DAP_SERVICE_BURST_US            800U
+
+// DWT program counter sample register
+#define DWT_PCSR_ADDR                   0xE000101CU
+// debug exception and monitor control register, TRCENA enables DWT
+#define DEMCR_ADDR                      0xE000EDFCU
+#define DEMCR_TRCENA                    (1U << 24)
+
+// halt watcher commands
+#define HALT_WATCH_START                0x00U
+#define HALT_WATCH_STOP                 0x01U
+#define HALT_WATCH_STATUS               0x02U
+// halt notification: type, reserved, halt count, DHCSR
+#define HALT_NOTIFY_TYPE                0x01U
+#define HALT_NOTIFY_SIZE                8U
+
+// debug halting control and status register
+#define DHCSR_ADDR                      0xE000EDF0U
+#define DHCSR_S_REGRDY                  (1U << 16)
+#define DHCSR_S_HALT                    (1U << 17)
+#define DHCSR_DBGKEY                    (0xA05FU << 16)
+#define DHCSR_C_DEBUGEN                 (1U << 0)
+#define DHCSR_C_HALT                    (1U << 1)
+#define DHCSR_C_MASKINTS                (1U << 3)
+// debug core register selector, DCRDR follows, TAR at DHCSR maps both to banked data registers
+#define DCRSR_REGWnR                    (1U << 16)
+// REGSEL of the registers used to call a flash algorithm
+#define CORE_REG_R0                     0U
+#define CORE_REG_R1                     1U
+#define CORE_REG_R2                     2U
+#define CORE_REG_R9                     9U
+#define CORE_REG_SP                     13U
+#define CORE_REG_LR                     14U
+#define CORE_REG_PC                     15U
+#define CORE_REG_XPSR                   16U
+#define XPSR_THUMB                      (1U << 24)
+
+// core register commands
+#define CORE_REG_READ                   0x00U
+#define CORE_REG_WRITE                  0x01U
+// core register request: command, ap, bitmap of REGSEL 0 .. 127
+#define CORE_REG_HEAD_SIZE              18U
+#define CORE_REG_BITMAP_SIZE            16U
+// S_REGRDY polls before giving up
+#define CORE_REG_RETRY                  100U
+
+// target memory read chunk in words
+#define MEM_CHUNK_WORDS                 64U
+// block compare request: ap, address, block size, count, response: status, done, mismatches
+#define MEM_CMP_REQ_HEAD_SIZE           11U
+#define MEM_CMP_RESP_HEAD_SIZE          5U
+// largest block, and largest range one request may hash, so a compare stays well inside the watchdog period
+#define MEM_CMP_BLOCK_MAX               0x10000U
+#define MEM_CMP_TOTAL_MAX               0x100000U
+
+// flash algorithm commands
+#define FLASH_ALGO_SETUP                0x00U
+#define FLASH_ALGO_DATA                 0x01U
+#define FLASH_ALGO_WAIT                 0x02U
+// flash algorithm setup: command, ap, breakpoint, static base, stack, ProgramPage, buffer 0, buffer 1, page size, timeout
+#define FLASH_ALGO_SETUP_SIZE           34U
+// flash algorithm data: command, flash address, offset, length
+#define FLASH_ALGO_DATA_HEAD_SIZE       9U
+// flash algorithm response: status, pages done, result of the last page
+#define FLASH_ALGO_RESP_SIZE            9U
+#define FLASH_ALGO_BUFFER_NUM           2U
+
+// RTT commands
+#define RTT_START                       0x00U
+#define RTT_STOP                        0x01U
+#define RTT_STATUS                      0x02U
+// RTT start: command, ap, RAM start, RAM size, up channel, down channel (0xFF : none)
+#define RTT_START_SIZE                  12U
+#define RTT_CHANNEL_NONE                0xFFU
+// RTT status response: status, state, control block, up bytes, down bytes, errors
+#define RTT_STATUS_SIZE                 18U
+// RTT control block: id, max up buffers, max down buffers, up buffers, down buffers
+#define RTT_CB_ID                       "SEGGER RTT"
+#define RTT_CB_ID_LEN                   11U
+#define RTT_CB_MAX_BUF                  16U
+#define RTT_CB_BUF_NUM_MAX              32U
+#define RTT_CB_HEAD_SIZE                24U
+// RTT buffer: name, buffer, size, write offset, read offset, flags
+#define RTT_BUF_SIZE                    24U
+#define RTT_BUF_BUFFER                  4U
+#define RTT_BUF_WR_OFF                  12U
+#define RTT_BUF_RD_OFF                  16U
+// RTT up data read in one poll, a chunk keeps one word for the unaligned head
+#define RTT_READ_MAX                    ((MEM_CHUNK_WORDS - 1U) * 4U)
+// RTT states
+#define RTT_IDLE                        0x00U
+#define RTT_SEARCH                      0x01U
+#define RTT_RUN                         0x02U
+
+// variable watch commands
+#define VAR_WATCH_START                 0x00U
+#define VAR_WATCH_STOP                  0x01U
+#define VAR_WATCH_FETCH                 0x02U
+// variable watch start: command, ap, interval(us), count, then address and width of each variable
+#define VAR_WATCH_START_HEAD_SIZE       7U
+#define VAR_WATCH_VAR_SIZE              5U
+#define VAR_WATCH_VAR_MAX               8U
+// variable watch fetch response: status, active, overflows, errors, record size, record count
+#define VAR_WATCH_HEAD_SIZE             13U
+// variable watch record: DWT timestamp, then the values packed by width
+#define VAR_WATCH_STAMP_SIZE            4U
+#define VAR_WATCH_BUF_SIZE              1024U
+
+// topology commands
+#define TOPO_DISCOVER                   0x00U
+#define TOPO_READ                       0x01U
+// topology discover: command, force, AP num, response: status, flags, blob len, APs, components
+#define TOPO_DISCOVER_SIZE              3U
+#define TOPO_DISCOVER_RESP_SIZE         6U
+#define TOPO_FLAG_VALID                 0x01U
+#define TOPO_FLAG_TRUNCATED             0x02U
+#define TOPO_FLAG_ADIV6                 0x04U
+// topology read: command, offset, response: status, len, data
+#define TOPO_READ_HEAD_SIZE             3U
+#define TOPO_AP_NUM_DEFAULT             16U
+#define TOPO_DEPTH_MAX                  4U
+#define TOPO_BLOB_SIZE                  512U
+// topology DP record, always first: type, DP version, reserved, DPIDR
+#define TOPO_REC_DP                     0x03U
+#define TOPO_REC_DP_SIZE                8U
+// topology AP record: type, ap, reserved, IDR, BASE
+#define TOPO_REC_AP                     0x01U
+#define TOPO_REC_AP_SIZE                12U
+// topology component record: type, ap, depth, PIDR4, address, CIDR, PIDR3..0
+#define TOPO_REC_COMP                   0x02U
+#define TOPO_REC_COMP_SIZE              16U
+// AP IDR class, MEM-AP
+#define AP_IDR_CLASS(idr)               (((idr) >> 13) & 0x0FU)
+#define AP_IDR_CLASS_MEM                0x08U
+// BASE: format and entry present
+#define AP_BASE_FORMAT                  (1U << 1)
+#define AP_BASE_PRESENT                 (1U << 0)
+#define AP_BASE_LEGACY_NONE             0xFFFFFFFFU
+// CoreSight component id block at 0xFD0 : PIDR4..7, PIDR0..3, CIDR0..3
+#define CS_ID_BLOCK                     0xFD0U
+#define CS_ID_WORDS                     12U
+#define CS_DEVARCH                      0xFBCU
+#define CS_CIDR_PREAMBLE_MASK           0xFFFF0FFFU
+#define CS_CIDR_PREAMBLE                0xB105000DU
+#define CS_CIDR_CLASS(cidr)             (((cidr) >> 12) & 0x0FU)
+#define CS_CLASS_ROM                    0x01U
+#define CS_CLASS_CORESIGHT              0x09U
+#define CS_DEVARCH_ROM_MASK             0xFFF0FFFFU
+#define CS_DEVARCH_ROM                  0x47700AF7U
+// ROM table entries of class 1 and class 9 tables
+#define CS_ROM_ENTRIES_CLASS1           960U
+#define CS_ROM_ENTRIES_CLASS9           512U
+// class 1 : bit 0 set, class 9 : PRESENT 0b11, 0b10 is an empty slot before the end
+#define CS_ROM_ENTRY_PRESENT            (1U << 0)
+#define CS_ROM_ENTRY_PRESENT9           0x03U
+#define CS_ROM_ENTRY_OFFSET             0xFFFFF000U
+
+// SWD multi-drop commands
+#define SWD_TARGET_CONFIG               0x00U
+#define SWD_TARGET_SWITCH               0x01U
+// SWD multi-drop config: command, count, TARGETSEL of each target
+#define SWD_TARGET_CONFIG_HEAD_SIZE     2U
+// SWD multi-drop switch: command, index, response: status, DPIDR
+#define SWD_TARGET_SWITCH_RESP_SIZE     5U
+
+// JTAG chain detect: apply, response: status, count, IR total, IR length and IDCODE of each device
+#define JTAG_DETECT_SIZE                1U
+#define JTAG_DETECT_HEAD_SIZE           4U
+#define JTAG_DETECT_DEV_SIZE            5U
+
+// RISC-V commands
+#define RISCV_DTM_SELECT                0x00U
+#define RISCV_DMI_BATCH                 0x01U
+#define RISCV_REG_ACCESS                0x02U
+#define RISCV_MEM_READ                  0x03U
+#define RISCV_MEM_WRITE                 0x04U
+// RISC-V DTM select: command, JTAG index, flags, response: ack, DTMCS
+#define RISCV_SELECT_SIZE               3U
+#define RISCV_SELECT_RESP_SIZE          5U
+#define RISCV_SELECT_HARD_RESET         0x01U
+// RISC-V DMI batch: command, count, op, address, data of writes, response: ack, done, data of reads
+#define RISCV_DMI_HEAD_SIZE             2U
+#define RISCV_DMI_OP_SIZE               5U
+// RISC-V register access: command, write, aarsize, count, regno, data of writes
+#define RISCV_REG_HEAD_SIZE             4U
+// RISC-V memory access: command, aarsize, address, count of words, data of writes
+#define RISCV_MEM_HEAD_SIZE             7U
+// RISC-V register and memory response: ack, cmderr, done, data of reads
+#define RISCV_RESP_HEAD_SIZE            3U
+// abstractcs busy polls before giving up, memory access restarts after busy
+#define RISCV_ABSTRACT_RETRY            100U
+#define RISCV_MEM_RETRY                 8U
+// debug module registers
+#define DM_DATA0                        0x04U
+#define DM_DATA1                        0x05U
+#define DM_DMSTATUS                     0x11U
+#define DM_ABSTRACTCS                   0x16U
+#define DM_COMMAND                      0x17U
+#define DM_ABSTRACTAUTO                 0x18U
+#define DM_PROGBUF0                     0x20U
+#define DMSTATUS_IMPEBREAK              (1U << 22)
+#define ABSTRACTCS_CMDERR(x)            (((x) >> 8) & 0x07U)
+#define ABSTRACTCS_CMDERR_CLR           (0x07U << 8)
+#define ABSTRACTCS_BUSY                 (1U << 12)
+#define ABSTRACTCS_PROGBUFSIZE(x)       (((x) >> 24) & 0x1FU)
+#define ABSTRACTAUTO_DATA0              (1U << 0)
+#define CMDERR_BUSY                     0x01U
+#define CMDERR_NOT_SUPPORTED            0x02U
+// access register abstract command
+#define AC_ACCESS_REG(aarsize, regno)   (((aarsize) << 20) | (regno))
+#define AC_POSTEXEC                     (1U << 18)
+#define AC_TRANSFER                     (1U << 17)
+#define AC_WRITE                        (1U << 16)
+#define AARSIZE_32                      0x02U
+#define AARSIZE_64                      0x03U
+// GPR s0, s1 and the program buffer instructions of the memory loops
+#define RISCV_REG_S0                    0x1008U
+#define RISCV_REG_S1                    0x1009U
+#define RV_LW_S1_S0                     0x00042483U     // lw s1, 0(s0)
+#define RV_SW_S1_S0                     0x00942023U     // sw s1, 0(s0)
+#define RV_ADDI_S0_4                    0x00440413U     // addi s0, s0, 4
+#define RV_EBREAK                       0x00100073U     // ebreak
+
+// boundary scan commands
+#define BSCAN_START                     0x00U
+#define BSCAN_STOP                      0x01U
+#define BSCAN_STATUS                    0x02U
+// boundary scan start: command, JTAG index, IR, boundary bits, rate, flags, TDI pattern
+#define BSCAN_START_HEAD_SIZE           13U
+#define BSCAN_FLAG_CHANGES              0x01U   // only samples that differ from the previous are queued
+#define BSCAN_BITS_MAX                  2048U
+#define BSCAN_BUF_SIZE                  2048U
+// boundary scan record: DWT cycle count, boundary bits
+#define BSCAN_STAMP_SIZE                4U
+// boundary scan status: status, active, samples, queued, dropped
+#define BSCAN_STATUS_SIZE               14U
+
+// SVF player commands
+#define SVF_RESET                       0x00U
+#define SVF_EXEC                        0x01U
+// SVF player operations, the encoding is shared with tools/svf_pack.c
+#define SVF_OP_STATE                    0x01U   // state
+#define SVF_OP_SIR                      0x02U   // flags, end state, bits, [repeat, wait us], TDI, [TDO, mask]
+#define SVF_OP_SDR                      0x03U
+#define SVF_OP_RUNTEST                  0x04U   // run state, end state, TCK count, wait us
+#define SVF_OP_TRST                     0x05U   // mode
+#define SVF_STATE_SIZE                  2U
+#define SVF_SCAN_HEAD_SIZE              5U
+#define SVF_RETRY_SIZE                  5U
+#define SVF_RUNTEST_SIZE                11U
+#define SVF_TRST_SIZE                   2U
+// SVF scan flags, a scan longer than SVF_CHUNK_BITS is split into chunks
+#define SVF_SCAN_FIRST                  0x01U   // move to Shift-IR/DR before the bits
+#define SVF_SCAN_LAST                   0x02U   // leave Shift-IR/DR on the last bit and move to the end state
+#define SVF_SCAN_COMPARE                0x04U   // TDO and mask follow TDI
+#define SVF_SCAN_RETRY                  0x08U   // XSVF repeat count and wait, only for a single chunk
+#define SVF_CHUNK_BITS                  1024U
+// SVF TRST modes
+#define SVF_TRST_ON                     0x00U
+#define SVF_TRST_OFF                    0x01U
+#define SVF_TRST_Z                      0x02U
+#define SVF_TRST_ABSENT                 0x03U
+// SVF player results, the session stops on the first error until the next reset
+#define SVF_RESULT_OK                   0x00U
+#define SVF_RESULT_MISMATCH             0x01U
+#define SVF_RESULT_BAD_OP               0x02U
+// SVF exec: command, payload len, payload; response: status, result, scan index, bit offset
+#define SVF_EXEC_HEAD_SIZE              3U
+#define SVF_RESP_SIZE                   10U
+// waits from this long give the CPU to other threads
+#define SVF_YIELD_US                    2000U
+// RUNTEST TCK clocked between yield checks, 0.5 s at 1 kHz
+#define SVF_CLOCK_SLICE                 512U
+
+/* PC sampling info */
+typedef struct
+{
+    uint8_t active;                             /* sampling is running */
+    uint8_t ap;                                 /* MEM-AP of the core */
+    uint8_t shift;                              /* bucket = (pc - base) >> shift */
+    uint32_t base;                              /* address of the first bucket */
+    uint32_t interval;                          /* DWT cycles between samples, 0 : as fast as the wire allows */
+    uint32_t next;                              /* DWT cycle count of the next sample */
+    uint32_t samples;                           /* samples taken */
+    uint32_t out_of_range;                      /* samples outside the buckets */
+    uint32_t no_pc;                             /* samples while the core is halted or sleeping */
+    uint32_t errors;                            /* failed samples */
+    uint32_t bucket[PC_SAMPLE_BUCKET_NUM];      /* histogram */
+} pc_sample_info_t;
+
+/* Halt watcher info */
+typedef struct
+{
+    uint8_t active;                             /* watcher is running */
+    uint8_t ap;                                 /* MEM-AP of the core */
+    uint8_t halted;                             /* core was halted at the last poll */
+    uint8_t latched;                            /* halt seen since the last status read */
+    uint8_t notify;                             /* halt notification waiting for sending */
+    uint16_t halt_count;                        /* halts seen since start */
+    uint32_t interval;                          /* ticks between polls */
+    uint32_t next;                              /* tick of the next poll */
+    uint32_t dhcsr;                             /* DHCSR at the last poll */
+    uint32_t errors;                            /* failed polls */
+} halt_watch_info_t;
+
+/* Flash algorithm runner info */
+typedef struct
+{
+    uint8_t ready;                              /* algorithm is set up */
+    uint8_t ap;                                 /* MEM-AP of the core */
+    uint8_t running;                            /* target is programming a page */
+    uint8_t run;                                /* buffer being programmed */
+    uint8_t fill;                               /* buffer filled by the host */
+    uint8_t buffer_num;                         /* 1 or 2 page buffers in target RAM */
+    uint32_t breakpoint;                        /* return address holding a BKPT instruction */
+    uint32_t static_base;                       /* R9 of the algorithm */
+    uint32_t stack_top;                         /* SP of the algorithm */
+    uint32_t program_page;                      /* ProgramPage(addr, size, buffer) entry */
+    uint32_t buffer[FLASH_ALGO_BUFFER_NUM];     /* page buffers in target RAM */
+    uint32_t page_addr[FLASH_ALGO_BUFFER_NUM];  /* flash address of the page in each buffer */
+    uint32_t page_size;                         /* page size in bytes */
+    uint32_t timeout;                           /* ticks allowed for one page */
+    uint32_t pages_done;                        /* pages programmed */
+    uint32_t result;                            /* R0 of the last page */
+    rt_tick_t start;                            /* tick the running page started */
+} flash_algo_info_t;
+
+/* RTT streamer info */
+typedef struct
+{
+    uint8_t state;                              /* idle, searching the control block or running */
+    uint8_t ap;                                 /* MEM-AP of the core */
+    uint8_t up_channel;                         /* up buffer streamed to the host */
+    uint8_t down_channel;                       /* down buffer fed by the host */
+    uint32_t ram_start;                         /* RAM range searched for the control block */
+    uint32_t ram_end;
+    uint32_t search;                            /* next address to search */
+    uint32_t cb;                                /* control block address */
+    uint32_t up_buf;                            /* up buffer descriptor address */
+    uint32_t down_buf;                          /* down buffer descriptor address */
+    uint32_t up_bytes;                          /* bytes read from the target */
+    uint32_t down_bytes;                        /* bytes written to the target */
+    uint32_t errors;                            /* failed transfers */
+} rtt_info_t;
+
+/* Fixed size record ring of the sampling services */
+typedef struct
+{
+    uint8_t *buffer;                            /* record storage */
+    uint16_t record_size;                       /* bytes of one record */
+    uint16_t record_num;                        /* records the buffer holds */
+    uint16_t head;                              /* next record to write */
+    uint16_t count;                             /* records waiting for the host */
+} record_ring_t;
+
+/* Variable watch info */
+typedef struct
+{
+    uint8_t active;                             /* sampling is running */
+    uint8_t ap;                                 /* MEM-AP of the core */
+    uint8_t num;                                /* variables */
+    uint8_t width[VAR_WATCH_VAR_MAX];           /* 1, 2 or 4 bytes */
+    uint32_t addr[VAR_WATCH_VAR_MAX];           /* variable addresses, aligned to the width */
+    uint32_t interval;                          /* DWT cycles between samples, 0 : as fast as the wire allows */
+    uint32_t next;                              /* DWT cycle count of the next sample */
+    uint32_t overflows;                         /* records dropped on a full buffer */
+    uint32_t errors;                            /* failed samples */
+    record_ring_t ring;                         /* records waiting for fetch */
+    uint8_t buffer[VAR_WATCH_BUF_SIZE];         /* record storage */
+} var_watch_info_t;
+
+/* Topology cache info */
+typedef struct
+{
+    uint8_t valid;                              /* discovered since connect or line reset */
+    uint8_t truncated;                          /* blob ran out of space */
+    uint8_t adiv6;                              /* ADIv6 DP, APs not scanned */
+    uint8_t ap_cnt;                             /* AP records */
+    uint8_t comp_cnt;                           /* component records */
+    uint16_t len;                               /* blob len */
+    uint8_t blob[TOPO_BLOB_SIZE];               /* AP and component records */
+} topo_info_t;
+
+/* Boundary scan sampling info */
+typedef struct
+{
+    uint8_t active;                             /* sampling is running */
+    uint8_t index;                              /* JTAG device index */
+    uint8_t flags;                              /* BSCAN_FLAG_CHANGES */
+    uint16_t bits;                              /* boundary register bits */
+    uint16_t bytes;                             /* bytes of the boundary register */
+    uint32_t ir;                                /* SAMPLE/PRELOAD or EXTEST */
+    uint32_t interval;                          /* DWT cycles between samples, 0 : as fast as the wire allows */
+    uint32_t next;                              /* DWT cycle count of the next sample */
+    uint32_t samples;                           /* boundary register scans */
+    uint32_t queued;                            /* records queued for the stream */
+    uint32_t dropped;                           /* records dropped on a full buffer */
+    record_ring_t ring;                         /* records waiting for the stream */
+    uint8_t tdi[BSCAN_BITS_MAX / 8U];           /* pattern shifted in, drives the pins in EXTEST */
+    uint8_t tdo[BSCAN_BITS_MAX / 8U];           /* boundary register captured */
+    uint8_t last[BSCAN_BITS_MAX / 8U];          /* last queued sample */
+    uint8_t buffer[BSCAN_BUF_SIZE];             /* record storage */
+} bscan_info_t;
+
+/* SVF player info */
+typedef struct
+{
+    uint8_t state;                              /* TAP state, JTAG_TAP_UNKNOWN after reset */
+    uint8_t result;                             /* SVF_RESULT_OK or the error stopping the session */
+    uint32_t scan;                              /* scans passed, index of the failing scan */
+    uint32_t scan_bit;                          /* bits of the current scan shifted by earlier chunks */
+    uint32_t fail_bit;                          /* first mismatching bit of the failing scan */
+    uint8_t tdo[SVF_CHUNK_BITS / 8U];           /* TDO captured */
+} svf_info_t;
+
 static uint8_t update_flag = 0;
+static dap_thread_stat_t thread_stat[THREAD_STAT_MAX];
+static pc_sample_info_t pc_sample;
+static halt_watch_info_t halt_watch;
+static uint32_t mem_chunk[MEM_CHUNK_WORDS];
+static flash_algo_info_t flash_algo;
+static rtt_info_t rtt;
+static var_watch_info_t var_watch;
+static topo_info_t topo;
+static bscan_info_t bscan;
+static svf_info_t svf;
+
+/**
+ * @brief DAP vendor thread statistics, report run cycles, switches and stack usage of each thread.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_thread_stat(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t max, total, cnt, resp_ptr;
+    uint64_t uptime;
+
+    if (remaining_size < THREAD_STAT_HEAD_SIZE)
+        return 0;
+
+    max = MIN((remaining_size - THREAD_STAT_HEAD_SIZE) / THREAD_STAT_ENTRY_SIZE, THREAD_STAT_MAX);
+    total = dap_thread_stat_get(thread_stat, *request, max, &uptime);
+    cnt = (total > *request) ? MIN(total - *request, max) : 0;
+
+    response[0] = DAP_OK;
+    response[1] = (uint8_t)total;
+    response[2] = (uint8_t)cnt;
+    __UNALIGNED_UINT32_WRITE(response + 3, (uint32_t)uptime);
+    __UNALIGNED_UINT32_WRITE(response + 7, (uint32_t)(uptime >> 32));
+    resp_ptr = THREAD_STAT_HEAD_SIZE;
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        rt_memcpy(response + resp_ptr, thread_stat[i].name, RT_NAME_MAX);
+        resp_ptr += RT_NAME_MAX;
+        response[resp_ptr++] = thread_stat[i].priority;
+        __UNALIGNED_UINT16_WRITE(response + resp_ptr, (uint16_t)thread_stat[i].stack_size);
+        __UNALIGNED_UINT16_WRITE(response + resp_ptr + 2, (uint16_t)thread_stat[i].stack_used);
+        __UNALIGNED_UINT32_WRITE(response + resp_ptr + 4, thread_stat[i].switches);
+        __UNALIGNED_UINT32_WRITE(response + resp_ptr + 8, (uint32_t)thread_stat[i].cycles);
+        __UNALIGNED_UINT32_WRITE(response + resp_ptr + 12, (uint32_t)(thread_stat[i].cycles >> 32));
+        resp_ptr += 16;
+    }
+
+    return (resp_ptr << 16) | 1U;
+}
+
+/**
+ * @brief Merge the wait time of a service, RT_WAITING_FOREVER is the longest.
+ *
+ * @param wait              Current wait ticks.
+ * @param service_wait      Wait ticks of the service.
+ *
+ * @return Wait ticks.
+ */
+static int32_t dap_service_wait(int32_t wait, int32_t service_wait)
+{
+    if (wait == RT_WAITING_FOREVER)
+        return service_wait;
+    if (service_wait == RT_WAITING_FOREVER)
+        return wait;
+    return MIN(wait, service_wait);
+}
+
+/**
+ * @brief Fixed rate pacing of the burst services. A sample less than a tick away is waited
+ *        for in the burst, a later one ends the burst and the DAP thread sleeps until it is due.
+ *
+ * @param next              A pointer to the DWT cycle count of the next sample, advanced when due.
+ * @param interval          DWT cycles between samples, 0 : as fast as the wire allows.
+ * @param wait              Set to the ticks to sleep when the burst has to end.
+ *
+ * @return 1 if a sample is due.
+ */
+static uint8_t dap_service_due(uint32_t *next, uint32_t interval, int32_t *wait)
+{
+    uint32_t cycles_per_tick = SystemCoreClock / RT_TICK_PER_SECOND;
+    int32_t remain;
+
+    if (!interval)
+        return true;
+    remain = (int32_t)(*next - dap_get_cur_tick());
+    if (remain <= 0)
+    {
+        *next += interval;
+        return true;
+    }
+    /* rounded down, the thread wakes early rather than late and waits out the rest */
+    if ((uint32_t)remain >= cycles_per_tick)
+        *wait = (int32_t)((uint32_t)remain / cycles_per_tick);
+    return false;
+}
+
+/**
+ * @brief PC sampling burst, reads DWT_PCSR through the MEM-AP until the burst time is used up.
+ *
+ * @param request_pending   Return 1 if the host has a request waiting.
+ *
+ * @return Wait ticks before the next burst.
+ */
+static int32_t pc_sample_poll(uint8_t (*request_pending)(void))
+{
+    uint32_t start = dap_get_cur_tick();
+    uint32_t pc, offset;
+    int32_t wait = 0;
+
+    if (!pc_sample.active)
+        return RT_WAITING_FOREVER;
+
+    if ((dap_ap_begin(pc_sample.ap) != DAP_TRANSFER_OK) || (dap_ap_write(AP_TAR, DWT_PCSR_ADDR) != DAP_TRANSFER_OK))
+    {
+        pc_sample.errors++;
+        dap_ap_end();
+        return 1;
+    }
+
+    /* samples missed between bursts are not made up */
+    if ((int32_t)(start - pc_sample.next) > 0)
+        pc_sample.next = start;
+
+    while (!dap_wait_us_noblock(start, DAP_SERVICE_BURST_US))
+    {
+        if (request_pending())
+            break;
+        if (!dap_service_due(&pc_sample.next, pc_sample.interval, &wait))
+        {
+            if (wait)
+                break;
+            continue;
+        }
+
+        if (dap_ap_read(AP_DRW, &pc) != DAP_TRANSFER_OK)
+        {
+            pc_sample.errors++;
+            break;
+        }
+        pc_sample.samples++;
+        offset = (pc - pc_sample.base) >> pc_sample.shift;
+        if (pc == 0xFFFFFFFFU)
+            pc_sample.no_pc++;
+        else if ((pc < pc_sample.base) || (offset >= PC_SAMPLE_BUCKET_NUM))
+            pc_sample.out_of_range++;
+        else
+            pc_sample.bucket[offset]++;
+    }
+    dap_ap_end();
+
+    if (request_pending())
+        return 0;
+    return wait ? wait : 1;
+}
+
+/**
+ * @brief DAP vendor PC sampling, the probe samples DWT_PCSR and builds a histogram.
+ *        start : ap, shift, base, rate(Hz, 0 : max), stop, fetch : first bucket.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_pc_sample(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t rate, demcr, first, cnt;
+
+    switch (request[0])
+    {
+        case PC_SAMPLE_START:
+            {
+                rate = __UNALIGNED_UINT32_READ(request + 7);
+                rt_memset(&pc_sample, 0, sizeof(pc_sample_info_t));
+                pc_sample.ap = request[1];
+                pc_sample.shift = MIN(request[2], 31U);
+                pc_sample.base = __UNALIGNED_UINT32_READ(request + 3);
+                pc_sample.interval = rate ? (SystemCoreClock / rate) : 0;
+                pc_sample.next = dap_get_cur_tick();
+
+                /* PCSR reads 0xFFFFFFFF until DWT is enabled */
+                response[0] = DAP_ERROR;
+                if (dap_ap_begin(pc_sample.ap) == DAP_TRANSFER_OK)
+                {
+                    if (dap_mem_read32(DEMCR_ADDR, &demcr) == DAP_TRANSFER_OK)
+                    {
+                        if ((demcr & DEMCR_TRCENA) || (dap_mem_write32(DEMCR_ADDR, demcr | DEMCR_TRCENA) == DAP_TRANSFER_OK))
+                        {
+                            pc_sample.active = true;
+                            response[0] = DAP_OK;
+                        }
+                    }
+                }
+                dap_ap_end();
+            }
+            return (1U << 16) | 11U;
+        case PC_SAMPLE_STOP:
+            {
+                pc_sample.active = false;
+                response[0] = DAP_OK;
+            }
+            return (1U << 16) | 1U;
+        case PC_SAMPLE_FETCH:
+            {
+                if (remaining_size < PC_SAMPLE_HEAD_SIZE)
+                    return 0;
+                first = MIN(__UNALIGNED_UINT16_READ(request + 1), PC_SAMPLE_BUCKET_NUM);
+                cnt = MIN(PC_SAMPLE_BUCKET_NUM - first, (remaining_size - PC_SAMPLE_HEAD_SIZE) / 4U);
+
+                response[0] = DAP_OK;
+                response[1] = pc_sample.active;
+                __UNALIGNED_UINT32_WRITE(response + 2, pc_sample.samples);
+                __UNALIGNED_UINT32_WRITE(response + 6, pc_sample.out_of_range);
+                __UNALIGNED_UINT32_WRITE(response + 10, pc_sample.no_pc);
+                __UNALIGNED_UINT32_WRITE(response + 14, pc_sample.errors);
+                __UNALIGNED_UINT16_WRITE(response + 18, PC_SAMPLE_BUCKET_NUM);
+                __UNALIGNED_UINT16_WRITE(response + 20, (uint16_t)first);
+                __UNALIGNED_UINT16_WRITE(response + 22, (uint16_t)cnt);
+                for (uint32_t i = 0; i < cnt; i++)
+                    __UNALIGNED_UINT32_WRITE(response + PC_SAMPLE_HEAD_SIZE + i * 4U, pc_sample.bucket[first + i]);
+            }
+            return ((PC_SAMPLE_HEAD_SIZE + cnt * 4U) << 16) | 3U;
+        default:
+            break;
+    }
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief Halt watcher poll, reads DHCSR and latches the running to halted transition.
+ *
+ * @return Wait ticks before the next poll.
+ */
+static int32_t halt_watch_poll(void)
+{
+    rt_tick_t now = rt_tick_get();
+    uint32_t dhcsr;
+    uint8_t ack;
+
+    if (!halt_watch.active)
+        return RT_WAITING_FOREVER;
+    if ((int32_t)(now - halt_watch.next) < 0)
+        return (int32_t)(halt_watch.next - now);
+    halt_watch.next = now + halt_watch.interval;
+
+    ack = dap_ap_begin(halt_watch.ap);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_mem_read32(DHCSR_ADDR, &dhcsr);
+    dap_ap_end();
+    if (ack != DAP_TRANSFER_OK)
+    {
+        halt_watch.errors++;
+        return (int32_t)halt_watch.interval;
+    }
+
+    halt_watch.dhcsr = dhcsr;
+    if (dhcsr & DHCSR_S_HALT)
+    {
+        if (!halt_watch.halted)
+        {
+            halt_watch.halt_count++;
+            halt_watch.latched = true;
+            halt_watch.notify = true;
+        }
+        halt_watch.halted = true;
+    }
+    else
+    {
+        halt_watch.halted = false;
+    }
+
+    return (int32_t)halt_watch.interval;
+}
+
+/**
+ * @brief DAP vendor halt watcher, the probe polls DHCSR while the target runs
+ *        and reports halts on the notify endpoint and in the latched status.
+ *        start : ap, interval(us), stop, status : clears the latch.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_halt_watch(uint8_t* request, uint8_t* response)
+{
+    uint32_t interval;
+
+    switch (request[0])
+    {
+        case HALT_WATCH_START:
+            {
+                interval = __UNALIGNED_UINT32_READ(request + 2);
+                rt_memset(&halt_watch, 0, sizeof(halt_watch_info_t));
+                halt_watch.ap = request[1];
+                halt_watch.interval = MAX(rt_tick_from_millisecond(interval / 1000U), 1U);
+                halt_watch.next = rt_tick_get();
+                halt_watch.active = true;
+                response[0] = DAP_OK;
+            }
+            return (1U << 16) | 6U;
+        case HALT_WATCH_STOP:
+            {
+                halt_watch.active = false;
+                halt_watch.notify = false;
+                response[0] = DAP_OK;
+            }
+            return (1U << 16) | 1U;
+        case HALT_WATCH_STATUS:
+            {
+                response[0] = DAP_OK;
+                response[1] = halt_watch.active;
+                response[2] = halt_watch.latched;
+                response[3] = halt_watch.halted;
+                __UNALIGNED_UINT16_WRITE(response + 4, halt_watch.halt_count);
+                __UNALIGNED_UINT32_WRITE(response + 6, halt_watch.dhcsr);
+                __UNALIGNED_UINT32_WRITE(response + 10, halt_watch.errors);
+                halt_watch.latched = false;
+            }
+            return (14U << 16) | 1U;
+        default:
+            break;
+    }
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief Transfer one core register through DCRSR/DCRDR, TAR must point at DHCSR.
+ *
+ * @param regsel            REGSEL of DCRSR.
+ * @param data              A pointer to the register value.
+ * @param write             1 : write the register.
+ *
+ * @return Ack of transfer, DAP_TRANSFER_ERROR if S_REGRDY is not set in time.
+ */
+static uint8_t core_reg_transfer(uint8_t regsel, uint32_t *data, uint8_t write)
+{
+    uint32_t dhcsr, retry = CORE_REG_RETRY;
+    uint8_t ack;
+
+    if (write)
+    {
+        ack = dap_ap_write(AP_BD2, *data);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+    }
+    ack = dap_ap_write(AP_BD1, regsel | (write ? DCRSR_REGWnR : 0));
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+
+    do
+    {
+        ack = dap_ap_read(AP_BD0, &dhcsr);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+    } while (!(dhcsr & DHCSR_S_REGRDY) && (--retry));
+    if (!(dhcsr & DHCSR_S_REGRDY))
+        return DAP_TRANSFER_ERROR;
+
+    return write ? DAP_TRANSFER_OK : dap_ap_read(AP_BD2, data);
+}
+
+/**
+ * @brief DAP vendor core register access, runs the DCRSR, S_REGRDY, DCRDR sequence for
+ *        every register of the bitmap, values follow in REGSEL order.
+ *        read : ap, bitmap, write : ap, bitmap, values. The core must be halted.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_core_reg(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint8_t write = (request[0] == CORE_REG_WRITE);
+    uint8_t *bitmap = request + 2;
+    uint32_t num = 0, cnt = 0, req_len = CORE_REG_HEAD_SIZE, dhcsr, data;
+    uint8_t ack;
+
+    for (uint32_t i = 0; i < CORE_REG_BITMAP_SIZE * 8U; i++)
+    {
+        if (bitmap[i >> 3] & (1U << (i & 7U)))
+            num++;
+    }
+    if (write)
+        req_len += num * 4U;
+    if ((request[0] > CORE_REG_WRITE) || (req_len > (DAP_PACKET_SIZE - 1U))
+        || (remaining_size < (2U + (write ? 0 : num * 4U))))
+    {
+        response[0] = DAP_ERROR;
+        response[1] = 0;
+        return (2U << 16) | MIN(req_len, DAP_PACKET_SIZE - 1U);
+    }
+
+    ack = dap_ap_begin(request[1]);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_write(AP_TAR, DHCSR_ADDR);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_read(AP_BD0, &dhcsr);
+    if ((ack == DAP_TRANSFER_OK) && !(dhcsr & DHCSR_S_HALT))
+        ack = DAP_TRANSFER_ERROR;
+
+    for (uint32_t i = 0; (i < CORE_REG_BITMAP_SIZE * 8U) && (ack == DAP_TRANSFER_OK); i++)
+    {
+        if (!(bitmap[i >> 3] & (1U << (i & 7U))))
+            continue;
+        if (write)
+        {
+            data = __UNALIGNED_UINT32_READ(request + CORE_REG_HEAD_SIZE + cnt * 4U);
+            ack = core_reg_transfer((uint8_t)i, &data, true);
+        }
+        else
+        {
+            ack = core_reg_transfer((uint8_t)i, &data, false);
+            __UNALIGNED_UINT32_WRITE(response + 2 + cnt * 4U, data);
+        }
+        if (ack == DAP_TRANSFER_OK)
+            cnt++;
+    }
+    dap_ap_end();
+
+    response[0] = (ack == DAP_TRANSFER_OK) ? DAP_OK : DAP_ERROR;
+    response[1] = (uint8_t)cnt;
+    if (write)
+        return (2U << 16) | req_len;
+    return ((2U + cnt * 4U) << 16) | req_len;
+}
+
+/**
+ * @brief CRC of a target memory range, read through the MEM-AP and fed into the CRC unit.
+ *        CRC-32/MPEG-2 of the little endian words, poly 0x04C11DB7, init 0xFFFFFFFF.
+ *
+ * @param addr              Target address, word aligned.
+ * @param words             Num of words.
+ * @param crc               A pointer to the CRC value.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t mem_crc_cal(uint32_t addr, uint32_t words, uint32_t *crc)
+{
+    uint32_t num;
+    uint8_t ack = DAP_TRANSFER_OK;
+
+    crc_cal_reset();
+    *crc = crc_cal_data(mem_chunk, 0);
+    while (words && (ack == DAP_TRANSFER_OK))
+    {
+        num = MIN(words, MEM_CHUNK_WORDS);
+        ack = dap_mem_read_block(addr, mem_chunk, num);
+        if (ack == DAP_TRANSFER_OK)
+            *crc = crc_cal_data(mem_chunk, num);
+        addr += num << 2;
+        words -= num;
+    }
+    return ack;
+}
+
+/**
+ * @brief DAP vendor target memory CRC, only the checksum goes back to the host.
+ *        request : ap, address, length in bytes (multiple of 4).
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_mem_crc(uint8_t* request, uint8_t* response)
+{
+    uint32_t addr = __UNALIGNED_UINT32_READ(request + 1);
+    uint32_t len = __UNALIGNED_UINT32_READ(request + 5);
+    uint32_t crc = 0;
+    uint8_t ack = DAP_TRANSFER_ERROR;
+
+    if (((addr | len) & 0x03U) == 0)
+    {
+        ack = dap_ap_begin(request[0]);
+        if (ack == DAP_TRANSFER_OK)
+            ack = mem_crc_cal(addr, len >> 2, &crc);
+        dap_ap_end();
+    }
+
+    response[0] = (ack == DAP_TRANSFER_OK) ? DAP_OK : DAP_ERROR;
+    __UNALIGNED_UINT32_WRITE(response + 1, crc);
+    return (5U << 16) | 9U;
+}
+
+/**
+ * @brief DAP vendor block compare, the probe hashes each block of the range and
+ *        returns the indices of blocks whose CRC differs from the host list.
+ *        request : ap, address, block size in bytes (multiple of 4), count, CRC list.
+ *        The block size is limited to MEM_CMP_BLOCK_MAX and block size * count to
+ *        MEM_CMP_TOTAL_MAX, larger ranges are split across requests by the host.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_mem_compare(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t addr = __UNALIGNED_UINT32_READ(request + 1);
+    uint32_t block = __UNALIGNED_UINT32_READ(request + 5);
+    uint16_t cnt = __UNALIGNED_UINT16_READ(request + 9);
+    uint32_t req_len = MEM_CMP_REQ_HEAD_SIZE + cnt * 4U;
+    uint16_t done = 0, mismatch = 0;
+    uint32_t crc;
+    uint8_t ack = DAP_TRANSFER_ERROR;
+
+    if ((((addr | block) & 0x03U) == 0) && block && (block <= MEM_CMP_BLOCK_MAX)
+        && ((block * cnt) <= MEM_CMP_TOTAL_MAX) && (req_len <= (DAP_PACKET_SIZE - 1U))
+        && (remaining_size >= (MEM_CMP_RESP_HEAD_SIZE + cnt * 2U)))
+    {
+        ack = dap_ap_begin(request[0]);
+        while ((done < cnt) && (ack == DAP_TRANSFER_OK))
+        {
+            ack = mem_crc_cal(addr + done * block, block >> 2, &crc);
+            if (ack != DAP_TRANSFER_OK)
+                break;
+            if (crc != __UNALIGNED_UINT32_READ(request + MEM_CMP_REQ_HEAD_SIZE + done * 4U))
+            {
+                __UNALIGNED_UINT16_WRITE(response + MEM_CMP_RESP_HEAD_SIZE + mismatch * 2U, done);
+                mismatch++;
+            }
+            done++;
+        }
+        dap_ap_end();
+    }
+    else
+    {
+        req_len = MIN(req_len, DAP_PACKET_SIZE - 1U);
+    }
+
+    response[0] = (ack == DAP_TRANSFER_OK) ? DAP_OK : DAP_ERROR;
+    __UNALIGNED_UINT16_WRITE(response + 1, done);
+    __UNALIGNED_UINT16_WRITE(response + 3, mismatch);
+    return ((MEM_CMP_RESP_HEAD_SIZE + mismatch * 2U) << 16) | req_len;
+}
+
+/**
+ * @brief Wait for the running page to return to the breakpoint and read its result from R0,
+ *        the core is halted again on timeout.
+ *
+ * @return Ack of transfer, DAP_TRANSFER_ERROR on timeout or a failed page.
+ */
+static uint8_t flash_algo_wait(void)
+{
+    uint32_t dhcsr;
+    uint8_t ack;
+
+    if (!flash_algo.running)
+        return DAP_TRANSFER_OK;
+
+    ack = dap_ap_write(AP_TAR, DHCSR_ADDR);
+    while (ack == DAP_TRANSFER_OK)
+    {
+        ack = dap_ap_read(AP_BD0, &dhcsr);
+        if ((ack != DAP_TRANSFER_OK) || (dhcsr & DHCSR_S_HALT))
+            break;
+        if ((rt_tick_get() - flash_algo.start) > flash_algo.timeout)
+        {
+            dap_ap_write(AP_BD0, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT);
+            ack = DAP_TRANSFER_ERROR;
+            break;
+        }
+        /* give the CPU to the idle thread, it feeds the watchdog during long erases */
+        rt_thread_mdelay(1);
+    }
+    flash_algo.running = false;
+
+    if (ack == DAP_TRANSFER_OK)
+        ack = core_reg_transfer(CORE_REG_R0, &flash_algo.result, false);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    if (flash_algo.result != 0)
+        return DAP_TRANSFER_ERROR;
+    flash_algo.pages_done++;
+    return DAP_TRANSFER_OK;
+}
+
+/**
+ * @brief Start ProgramPage(addr, size, buffer) on a filled buffer, the core is halted
+ *        and returns to the breakpoint.
+ *
+ * @param idx               Buffer index.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t flash_algo_run(uint8_t idx)
+{
+    const uint32_t regs[][2] =
+    {
+        {CORE_REG_R0, flash_algo.page_addr[idx]},
+        {CORE_REG_R1, flash_algo.page_size},
+        {CORE_REG_R2, flash_algo.buffer[idx]},
+        {CORE_REG_R9, flash_algo.static_base},
+        {CORE_REG_SP, flash_algo.stack_top},
+        {CORE_REG_LR, flash_algo.breakpoint | 1U},
+        {CORE_REG_PC, flash_algo.program_page},
+        {CORE_REG_XPSR, XPSR_THUMB},
+    };
+    uint32_t data;
+    uint8_t ack = dap_ap_write(AP_TAR, DHCSR_ADDR);
+
+    for (uint32_t i = 0; (i < sizeof(regs) / sizeof(regs[0])) && (ack == DAP_TRANSFER_OK); i++)
+    {
+        data = regs[i][1];
+        ack = core_reg_transfer((uint8_t)regs[i][0], &data, true);
+    }
+    /* C_MASKINTS only changes while halted */
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_write(AP_BD0, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_HALT | DHCSR_C_MASKINTS);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_ap_write(AP_BD0, DHCSR_DBGKEY | DHCSR_C_DEBUGEN | DHCSR_C_MASKINTS);
+    if (ack == DAP_TRANSFER_OK)
+    {
+        flash_algo.running = true;
+        flash_algo.run = idx;
+        flash_algo.start = rt_tick_get();
+    }
+    return ack;
+}
+
+/**
+ * @brief DAP vendor flash algorithm runner, the probe runs the ProgramPage loop of a CMSIS-Pack
+ *        style algorithm already loaded in target RAM. With two buffers the host fills one
+ *        while the target programs the other.
+ *        setup : ap, breakpoint, static base, stack, ProgramPage, buffer 0, buffer 1 (0 : none), page size, timeout(ms).
+ *        data : flash address, offset, length, data, the page is programmed once it is full.
+ *        wait : wait for the last page.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_flash_algo(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t req_len = 1, offset, len;
+    uint8_t ack = DAP_TRANSFER_ERROR;
+
+    if (remaining_size < FLASH_ALGO_RESP_SIZE)
+        return 0;
+
+    switch (request[0])
+    {
+        case FLASH_ALGO_SETUP:
+            {
+                req_len = FLASH_ALGO_SETUP_SIZE;
+                rt_memset(&flash_algo, 0, sizeof(flash_algo_info_t));
+                flash_algo.ap = request[1];
+                flash_algo.breakpoint = __UNALIGNED_UINT32_READ(request + 2);
+                flash_algo.static_base = __UNALIGNED_UINT32_READ(request + 6);
+                flash_algo.stack_top = __UNALIGNED_UINT32_READ(request + 10);
+                flash_algo.program_page = __UNALIGNED_UINT32_READ(request + 14);
+                flash_algo.buffer[0] = __UNALIGNED_UINT32_READ(request + 18);
+                flash_algo.buffer[1] = __UNALIGNED_UINT32_READ(request + 22);
+                flash_algo.page_size = __UNALIGNED_UINT32_READ(request + 26);
+                flash_algo.timeout = rt_tick_from_millisecond(__UNALIGNED_UINT32_READ(request + 30));
+                flash_algo.buffer_num = flash_algo.buffer[1] ? 2 : 1;
+                if (flash_algo.page_size && !(flash_algo.page_size & 0x03U))
+                {
+                    flash_algo.ready = true;
+                    ack = DAP_TRANSFER_OK;
+                }
+            }
+            break;
+        case FLASH_ALGO_DATA:
+            {
+                offset = __UNALIGNED_UINT16_READ(request + 5);
+                len = __UNALIGNED_UINT16_READ(request + 7);
+                req_len = MIN(FLASH_ALGO_DATA_HEAD_SIZE + len, DAP_PACKET_SIZE);
+                if (!flash_algo.ready || ((offset | len) & 0x03U) || ((offset + len) > flash_algo.page_size)
+                    || ((FLASH_ALGO_DATA_HEAD_SIZE + len) > DAP_PACKET_SIZE))
+                    break;
+
+                ack = dap_ap_begin(flash_algo.ap);
+                /* single buffer still being programmed */
+                if ((ack == DAP_TRANSFER_OK) && flash_algo.running && (flash_algo.run == flash_algo.fill))
+                    ack = flash_algo_wait();
+                if (ack == DAP_TRANSFER_OK)
+                {
+                    flash_algo.page_addr[flash_algo.fill] = __UNALIGNED_UINT32_READ(request + 1);
+                    ack = dap_mem_write_block(flash_algo.buffer[flash_algo.fill] + offset,
+                                              request + FLASH_ALGO_DATA_HEAD_SIZE, len >> 2);
+                }
+                /* page full, wait for the other buffer and start this one */
+                if ((ack == DAP_TRANSFER_OK) && ((offset + len) == flash_algo.page_size))
+                {
+                    ack = flash_algo_wait();
+                    if (ack == DAP_TRANSFER_OK)
+                        ack = flash_algo_run(flash_algo.fill);
+                    flash_algo.fill = (flash_algo.fill + 1) % flash_algo.buffer_num;
+                }
+                dap_ap_end();
+            }
+            break;
+        case FLASH_ALGO_WAIT:
+            {
+                if (!flash_algo.ready)
+                    break;
+                ack = dap_ap_begin(flash_algo.ap);
+                if (ack == DAP_TRANSFER_OK)
+                    ack = flash_algo_wait();
+                dap_ap_end();
+            }
+            break;
+        default:
+            break;
+    }
+
+    response[0] = (ack == DAP_TRANSFER_OK) ? DAP_OK : DAP_ERROR;
+    __UNALIGNED_UINT32_WRITE(response + 1, flash_algo.pages_done);
+    __UNALIGNED_UINT32_WRITE(response + 5, flash_algo.result);
+    return (FLASH_ALGO_RESP_SIZE << 16) | req_len;
+}
+
+/**
+ * @brief RTT control block search, one chunk of the RAM range per poll, the search wraps
+ *        around until the target has set up the control block.
+ *
+ * @return Wait ticks before the next poll.
+ */
+static int32_t rtt_poll(void)
+{
+    uint32_t cnt, max[2];
+    uint8_t ack;
+
+    if (rtt.state == RTT_IDLE)
+        return RT_WAITING_FOREVER;
+    if (rtt.state == RTT_RUN)
+        return 1;
+
+    if ((rtt.ram_end - rtt.search) < RTT_CB_HEAD_SIZE)
+        rtt.search = rtt.ram_start;
+    cnt = MIN(MEM_CHUNK_WORDS, (rtt.ram_end - rtt.search) >> 2);
+
+    ack = dap_ap_begin(rtt.ap);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_mem_read_block(rtt.search, mem_chunk, cnt);
+    for (uint32_t i = 0; (ack == DAP_TRANSFER_OK) && ((i + (RTT_CB_ID_LEN + 3U) / 4U) <= cnt); i++)
+    {
+        if (rt_memcmp(&mem_chunk[i], RTT_CB_ID, RTT_CB_ID_LEN) != 0)
+            continue;
+        rtt.cb = rtt.search + (i << 2);
+        ack = dap_mem_read_block(rtt.cb + RTT_CB_MAX_BUF, max, 2);
+        if ((ack == DAP_TRANSFER_OK) && (max[0] <= RTT_CB_BUF_NUM_MAX) && (max[1] <= RTT_CB_BUF_NUM_MAX)
+            && (rtt.up_channel < max[0]) && ((rtt.down_channel == RTT_CHANNEL_NONE) || (rtt.down_channel < max[1])))
+        {
+            rtt.up_buf = rtt.cb + RTT_CB_HEAD_SIZE + rtt.up_channel * RTT_BUF_SIZE;
+            rtt.down_buf = rtt.cb + RTT_CB_HEAD_SIZE + (max[0] + rtt.down_channel) * RTT_BUF_SIZE;
+            rtt.state = RTT_RUN;
+        }
+        break;
+    }
+    dap_ap_end();
+
+    if (ack != DAP_TRANSFER_OK)
+        rtt.errors++;
+    /* keep the id words of the chunk end for the next chunk */
+    rtt.search += (cnt > 3U) ? ((cnt - 3U) << 2) : (cnt << 2);
+    return 1;
+}
+
+/**
+ * @brief Read one RTT buffer descriptor, the search restarts if it does not look sane.
+ *
+ * @param buf               Buffer descriptor address.
+ * @param desc              Buffer, size, write offset, read offset.
+ *
+ * @return Ack of transfer, DAP_TRANSFER_ERROR if the descriptor is broken.
+ */
+static uint8_t rtt_buf_read(uint32_t buf, uint32_t *desc)
+{
+    uint8_t ack = dap_mem_read_block(buf + RTT_BUF_BUFFER, desc, 4);
+
+    if ((ack == DAP_TRANSFER_OK) && (!desc[1] || (desc[2] >= desc[1]) || (desc[3] >= desc[1])))
+    {
+        rtt.state = RTT_SEARCH;
+        rtt.search = rtt.ram_start;
+        ack = DAP_TRANSFER_ERROR;
+    }
+    return ack;
+}
+
+/**
+ * @brief RTT up channel drain, called by the DAP thread when the host side can take data.
+ *
+ * @param buf               A pointer to the data buffer.
+ * @param size              Size of the data buffer.
+ *
+ * @return Len of data read from the target.
+ */
+uint16_t dap_vendor_rtt_read(uint8_t *buf, uint16_t size)
+{
+    uint32_t desc[4], addr, len = 0;
+    uint8_t ack;
+
+    if (rtt.state != RTT_RUN)
+        return 0;
+
+    ack = dap_ap_begin(rtt.ap);
+    if (ack == DAP_TRANSFER_OK)
+        ack = rtt_buf_read(rtt.up_buf, desc);
+    if ((ack == DAP_TRANSFER_OK) && (desc[2] != desc[3]))
+    {
+        len = ((desc[2] > desc[3]) ? desc[2] : desc[1]) - desc[3];
+        len = MIN(len, MIN(size, RTT_READ_MAX));
+        addr = desc[0] + desc[3];
+        ack = dap_mem_read_block(addr & ~0x03U, mem_chunk, ((addr & 0x03U) + len + 3U) >> 2);
+        if (ack == DAP_TRANSFER_OK)
+        {
+            rt_memcpy(buf, (uint8_t *)mem_chunk + (addr & 0x03U), len);
+            ack = dap_mem_write32(rtt.up_buf + RTT_BUF_RD_OFF, (desc[3] + len) % desc[1]);
+        }
+    }
+    dap_ap_end();
+
+    if (ack != DAP_TRANSFER_OK)
+    {
+        rtt.errors++;
+        return 0;
+    }
+    rtt.up_bytes += len;
+    return (uint16_t)len;
+}
+
+/**
+ * @brief RTT down channel feed, called by the DAP thread with data from the host.
+ *
+ * @param buf               A pointer to the data.
+ * @param len               Len of data.
+ *
+ * @return Len of data taken, data is dropped while RTT is stopped.
+ */
+uint16_t dap_vendor_rtt_write(const uint8_t *buf, uint16_t len)
+{
+    uint32_t desc[4], space;
+    uint8_t ack;
+
+    if ((rtt.state == RTT_IDLE) || (rtt.down_channel == RTT_CHANNEL_NONE))
+        return len;
+    if (rtt.state != RTT_RUN)
+        return 0;
+
+    ack = dap_ap_begin(rtt.ap);
+    if (ack == DAP_TRANSFER_OK)
+        ack = rtt_buf_read(rtt.down_buf, desc);
+    if (ack == DAP_TRANSFER_OK)
+    {
+        /* one byte is kept free to tell full from empty */
+        if (desc[3] > desc[2])
+            space = desc[3] - desc[2] - 1U;
+        else
+            space = desc[1] - desc[2] - (desc[3] ? 0 : 1U);
+        len = MIN(len, space);
+        ack = dap_mem_write_bytes(desc[0] + desc[2], buf, len);
+        if ((ack == DAP_TRANSFER_OK) && len)
+            ack = dap_mem_write32(rtt.down_buf + RTT_BUF_WR_OFF, (desc[2] + len) % desc[1]);
+    }
+    dap_ap_end();
+
+    if (ack != DAP_TRANSFER_OK)
+    {
+        rtt.errors++;
+        return 0;
+    }
+    rtt.down_bytes += len;
+    return len;
+}
+
+/**
+ * @brief RTT streamer is started, host data is dropped at once while it is not.
+ *
+ * @return 1 : searching or running.
+ */
+uint8_t dap_vendor_rtt_active(void)
+{
+    return (rtt.state != RTT_IDLE);
+}
+
+/**
+ * @brief DAP vendor RTT streamer, the probe finds the RTT control block and moves
+ *        the channel data between the target and the RTT CDC ACM interface.
+ *        start : ap, RAM start, RAM size, up channel, down channel, stop, status.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_rtt(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t size;
+
+    switch (request[0])
+    {
+        case RTT_START:
+            {
+                size = __UNALIGNED_UINT32_READ(request + 6) & ~0x03U;
+                rt_memset(&rtt, 0, sizeof(rtt_info_t));
+                rtt.ap = request[1];
+                rtt.ram_start = __UNALIGNED_UINT32_READ(request + 2) & ~0x03U;
+                rtt.ram_end = rtt.ram_start + size;
+                rtt.search = rtt.ram_start;
+                rtt.up_channel = request[10];
+                rtt.down_channel = request[11];
+                if ((size >= RTT_CB_HEAD_SIZE) && (rtt.ram_end > rtt.ram_start) && !bscan.active)
+                {
+                    rtt.state = RTT_SEARCH;
+                    response[0] = DAP_OK;
+                }
+                else
+                {
+                    response[0] = DAP_ERROR;
+                }
+            }
+            return (1U << 16) | RTT_START_SIZE;
+        case RTT_STOP:
+            {
+                rtt.state = RTT_IDLE;
+                response[0] = DAP_OK;
+            }
+            return (1U << 16) | 1U;
+        case RTT_STATUS:
+            {
+                if (remaining_size < RTT_STATUS_SIZE)
+                    return 0;
+                response[0] = DAP_OK;
+                response[1] = rtt.state;
+                __UNALIGNED_UINT32_WRITE(response + 2, (rtt.state == RTT_RUN) ? rtt.cb : 0);
+                __UNALIGNED_UINT32_WRITE(response + 6, rtt.up_bytes);
+                __UNALIGNED_UINT32_WRITE(response + 10, rtt.down_bytes);
+                __UNALIGNED_UINT32_WRITE(response + 14, rtt.errors);
+            }
+            return (RTT_STATUS_SIZE << 16) | 1U;
+        default:
+            break;
+    }
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief Record ring init, the buffer is cut into as many records as fit.
+ *
+ * @param ring              A pointer to the ring.
+ * @param buffer            A pointer to the record storage.
+ * @param size              Size of the record storage.
+ * @param record_size       Bytes of one record, not 0.
+ *
+ * @return None.
+ */
+static void record_ring_init(record_ring_t *ring, uint8_t *buffer, uint32_t size, uint32_t record_size)
+{
+    ring->buffer = buffer;
+    ring->record_size = (uint16_t)record_size;
+    ring->record_num = (uint16_t)(size / record_size);
+    ring->head = 0;
+    ring->count = 0;
+}
+
+/**
+ * @brief Get the record slot to fill next, it is queued by record_ring_push.
+ *
+ * @param ring              A pointer to the ring.
+ *
+ * @return A pointer to the slot, NULL if the ring is full.
+ */
+static uint8_t *record_ring_slot(record_ring_t *ring)
+{
+    if (ring->count >= ring->record_num)
+        return NULL;
+    return &ring->buffer[ring->head * ring->record_size];
+}
+
+/**
+ * @brief Queue the record filled in the slot from record_ring_slot.
+ *
+ * @param ring              A pointer to the ring.
+ *
+ * @return None.
+ */
+static void record_ring_push(record_ring_t *ring)
+{
+    ring->head = (ring->head + 1U) % ring->record_num;
+    ring->count++;
+}
+
+/**
+ * @brief Take the oldest whole records that fit a buffer, the DAP thread is the only
+ *        writer so no lock is needed.
+ *
+ * @param ring              A pointer to the ring.
+ * @param buf               A pointer to the data buffer.
+ * @param size              Size of the data buffer.
+ *
+ * @return Records copied.
+ */
+static uint32_t record_ring_pop(record_ring_t *ring, uint8_t *buf, uint32_t size)
+{
+    uint32_t cnt, tail;
+
+    if (!ring->record_size)
+        return 0;
+    cnt = MIN(ring->count, size / ring->record_size);
+    tail = (ring->head + ring->record_num - ring->count) % ring->record_num;
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        rt_memcpy(buf + i * ring->record_size, &ring->buffer[tail * ring->record_size], ring->record_size);
+        tail = (tail + 1U) % ring->record_num;
+    }
+    ring->count -= (uint16_t)cnt;
+    return cnt;
+}
+
+/**
+ * @brief Variable watch burst, reads all variables each interval and queues a timestamped
+ *        record until the burst time is used up.
+ *
+ * @param request_pending   Return 1 if the host has a request waiting.
+ *
+ * @return Wait ticks before the next burst.
+ */
+static int32_t var_watch_poll(uint8_t (*request_pending)(void))
+{
+    uint32_t start = dap_get_cur_tick();
+    uint32_t data, offset;
+    uint8_t *record;
+    uint8_t ack = DAP_TRANSFER_OK;
+    int32_t wait = 0;
+
+    if (!var_watch.active)
+        return RT_WAITING_FOREVER;
+
+    if (dap_ap_begin(var_watch.ap) != DAP_TRANSFER_OK)
+    {
+        var_watch.errors++;
+        dap_ap_end();
+        return 1;
+    }
+
+    /* samples missed between bursts are not made up */
+    if ((int32_t)(start - var_watch.next) > 0)
+        var_watch.next = start;
+
+    while (!dap_wait_us_noblock(start, DAP_SERVICE_BURST_US))
+    {
+        if (request_pending())
+            break;
+        if (!dap_service_due(&var_watch.next, var_watch.interval, &wait))
+        {
+            if (wait)
+                break;
+            continue;
+        }
+
+        if ((record = record_ring_slot(&var_watch.ring)) == NULL)
+        {
+            var_watch.overflows++;
+            continue;
+        }
+        __UNALIGNED_UINT32_WRITE(record, dap_get_cur_tick());
+        offset = VAR_WATCH_STAMP_SIZE;
+        for (uint32_t i = 0; (i < var_watch.num) && (ack == DAP_TRANSFER_OK); i++)
+        {
+            ack = dap_mem_read32(var_watch.addr[i] & ~0x03U, &data);
+            data >>= (var_watch.addr[i] & 0x03U) << 3;
+            rt_memcpy(record + offset, &data, var_watch.width[i]);
+            offset += var_watch.width[i];
+        }
+        if (ack != DAP_TRANSFER_OK)
+        {
+            var_watch.errors++;
+            break;
+        }
+        record_ring_push(&var_watch.ring);
+    }
+    dap_ap_end();
+
+    if (request_pending())
+        return 0;
+    return wait ? wait : 1;
+}
+
+/**
+ * @brief DAP vendor variable watch, the probe samples up to VAR_WATCH_VAR_MAX target variables
+ *        at a fixed rate and queues timestamped records for the host.
+ *        start : ap, interval(us, 0 : max), count, address and width of each variable,
+ *        stop, fetch : returns the oldest records that fit the response.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_var_watch(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t num, cnt, width, interval, record_size;
+    uint8_t ok = true;
+
+    switch (request[0])
+    {
+        case VAR_WATCH_START:
+            {
+                num = request[6];
+                interval = __UNALIGNED_UINT32_READ(request + 2);
+                rt_memset(&var_watch, 0, sizeof(var_watch_info_t));
+                if ((num == 0) || (num > VAR_WATCH_VAR_MAX))
+                {
+                    response[0] = DAP_ERROR;
+                    return (1U << 16) | MIN(VAR_WATCH_START_HEAD_SIZE + num * VAR_WATCH_VAR_SIZE, DAP_PACKET_SIZE - 1U);
+                }
+
+                var_watch.ap = request[1];
+                var_watch.num = (uint8_t)num;
+                record_size = VAR_WATCH_STAMP_SIZE;
+                for (uint32_t i = 0; i < num; i++)
+                {
+                    var_watch.addr[i] = __UNALIGNED_UINT32_READ(request + VAR_WATCH_START_HEAD_SIZE + i * VAR_WATCH_VAR_SIZE);
+                    width = request[VAR_WATCH_START_HEAD_SIZE + i * VAR_WATCH_VAR_SIZE + 4];
+                    if (((width != 1U) && (width != 2U) && (width != 4U)) || (var_watch.addr[i] & (width - 1U)))
+                        ok = false;
+                    var_watch.width[i] = (uint8_t)width;
+                    record_size += width;
+                }
+                record_ring_init(&var_watch.ring, var_watch.buffer, VAR_WATCH_BUF_SIZE, record_size);
+                var_watch.interval = (uint32_t)(((uint64_t)SystemCoreClock * interval) / 1000000U);
+                var_watch.next = dap_get_cur_tick();
+                var_watch.active = ok;
+                response[0] = ok ? DAP_OK : DAP_ERROR;
+            }
+            return (1U << 16) | (VAR_WATCH_START_HEAD_SIZE + num * VAR_WATCH_VAR_SIZE);
+        case VAR_WATCH_STOP:
+            {
+                var_watch.active = false;
+                response[0] = DAP_OK;
+            }
+            return (1U << 16) | 1U;
+        case VAR_WATCH_FETCH:
+            {
+                if (remaining_size < VAR_WATCH_HEAD_SIZE)
+                    return 0;
+                cnt = record_ring_pop(&var_watch.ring, response + VAR_WATCH_HEAD_SIZE, remaining_size - VAR_WATCH_HEAD_SIZE);
+
+                response[0] = DAP_OK;
+                response[1] = var_watch.active;
+                __UNALIGNED_UINT32_WRITE(response + 2, var_watch.overflows);
+                __UNALIGNED_UINT32_WRITE(response + 6, var_watch.errors);
+                response[10] = (uint8_t)var_watch.ring.record_size;
+                __UNALIGNED_UINT16_WRITE(response + 11, (uint16_t)cnt);
+            }
+            return ((VAR_WATCH_HEAD_SIZE + cnt * var_watch.ring.record_size) << 16) | 1U;
+        default:
+            break;
+    }
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief Append a record to the topology blob.
+ *
+ * @param record            A pointer to the record.
+ * @param len               Len of record.
+ *
+ * @return true if the record fits.
+ */
+static uint8_t topo_add(const uint8_t *record, uint32_t len)
+{
+    if ((topo.len + len) > TOPO_BLOB_SIZE)
+    {
+        topo.truncated = true;
+        return false;
+    }
+    rt_memcpy(&topo.blob[topo.len], record, len);
+    topo.len += len;
+    return true;
+}
+
+/**
+ * @brief Record a CoreSight component and walk it if it is a ROM table.
+ *
+ * @param ap                AP num.
+ * @param addr              Component base address.
+ * @param depth             ROM table depth, 0 : AP BASE.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t topo_component(uint8_t ap, uint32_t addr, uint8_t depth)
+{
+    uint8_t record[TOPO_REC_COMP_SIZE];
+    uint32_t cidr = 0, pidr = 0, entries = 0, present = CS_ROM_ENTRY_PRESENT, devarch, entry;
+    uint8_t ack;
+
+    ack = dap_mem_read_block(addr + CS_ID_BLOCK, mem_chunk, CS_ID_WORDS);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+    for (uint32_t i = 0; i < 4U; i++)
+    {
+        pidr |= (mem_chunk[4U + i] & 0xFFU) << (i << 3);
+        cidr |= (mem_chunk[8U + i] & 0xFFU) << (i << 3);
+    }
+    if ((cidr & CS_CIDR_PREAMBLE_MASK) != CS_CIDR_PREAMBLE)
+        return DAP_TRANSFER_OK;
+
+    record[0] = TOPO_REC_COMP;
+    record[1] = ap;
+    record[2] = depth;
+    record[3] = (uint8_t)mem_chunk[0];
+    __UNALIGNED_UINT32_WRITE(record + 4, addr);
+    __UNALIGNED_UINT32_WRITE(record + 8, cidr);
+    __UNALIGNED_UINT32_WRITE(record + 12, pidr);
+    if (!topo_add(record, TOPO_REC_COMP_SIZE))
+        return DAP_TRANSFER_OK;
+    topo.comp_cnt++;
+
+    if (depth >= TOPO_DEPTH_MAX)
+        return DAP_TRANSFER_OK;
+    if (CS_CIDR_CLASS(cidr) == CS_CLASS_ROM)
+    {
+        entries = CS_ROM_ENTRIES_CLASS1;
+    }
+    else if (CS_CIDR_CLASS(cidr) == CS_CLASS_CORESIGHT)
+    {
+        ack = dap_mem_read32(addr + CS_DEVARCH, &devarch);
+        if ((ack == DAP_TRANSFER_OK) && ((devarch & CS_DEVARCH_ROM_MASK) == CS_DEVARCH_ROM))
+        {
+            entries = CS_ROM_ENTRIES_CLASS9;
+            present = CS_ROM_ENTRY_PRESENT9;
+        }
+    }
+
+    /* entries are read one by one, mem_chunk is reused by the children */
+    for (uint32_t i = 0; (i < entries) && (ack == DAP_TRANSFER_OK) && !topo.truncated; i++)
+    {
+        ack = dap_mem_read32(addr + (i << 2), &entry);
+        if ((ack != DAP_TRANSFER_OK) || (entry == 0))
+            break;
+        if ((entry & present) == present)
+            ack = topo_component(ap, addr + (entry & CS_ROM_ENTRY_OFFSET), depth + 1U);
+    }
+    return ack;
+}
+
+/**
+ * @brief Discover the APs and walk the ROM table of each MEM-AP into the topology blob.
+ *        Only ADIv5 APSEL addressing is scanned, an ADIv6 DP (DPIDR version 3) keeps
+ *        its APs in the memory map behind the DP base pointer, so only the DP record
+ *        is reported and the adiv6 flag is set instead of a misleading APSEL scan.
+ *
+ * @param ap_num            APs to scan.
+ *
+ * @return None.
+ */
+static void topo_discover(uint32_t ap_num)
+{
+    uint8_t record[TOPO_REC_AP_SIZE];
+    uint32_t idr, base;
+    uint8_t ack;
+
+    rt_memset(&topo, 0, sizeof(topo_info_t));
+
+    /* a DPv0 JTAG-DP reads DPIDR as zero, which is still ADIv5 */
+    ack = dap_ap_open(0);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_dp_read(DP_IDCODE, &idr);
+    dap_ap_end();
+    if (ack != DAP_TRANSFER_OK)
+        return;
+    record[0] = TOPO_REC_DP;
+    record[1] = (uint8_t)DP_IDR_VERSION(idr);
+    record[2] = 0;
+    record[3] = 0;
+    __UNALIGNED_UINT32_WRITE(record + 4, idr);
+    topo_add(record, TOPO_REC_DP_SIZE);
+    if (DP_IDR_VERSION(idr) >= DP_IDR_VERSION_ADIV6)
+    {
+        topo.adiv6 = true;
+        topo.valid = true;
+        return;
+    }
+
+    for (uint32_t ap = 0; (ap < ap_num) && !topo.truncated; ap++)
+    {
+        /* IDR and BASE need no CSW, which means something else on a non MEM-AP */
+        ack = dap_ap_open((uint8_t)ap);
+        if (ack == DAP_TRANSFER_OK)
+            ack = dap_ap_read(AP_IDR, &idr);
+        if ((ack == DAP_TRANSFER_OK) && idr)
+            ack = dap_ap_read(AP_BASE, &base);
+        dap_ap_end();
+        if (ack != DAP_TRANSFER_OK)
+            return;
+        if (idr == 0)
+            continue;
+
+        record[0] = TOPO_REC_AP;
+        record[1] = (uint8_t)ap;
+        record[2] = 0;
+        record[3] = 0;
+        __UNALIGNED_UINT32_WRITE(record + 4, idr);
+        __UNALIGNED_UINT32_WRITE(record + 8, base);
+        if (!topo_add(record, TOPO_REC_AP_SIZE))
+            break;
+        topo.ap_cnt++;
+
+        if ((AP_IDR_CLASS(idr) != AP_IDR_CLASS_MEM) || (base == AP_BASE_LEGACY_NONE)
+            || ((base & AP_BASE_FORMAT) && !(base & AP_BASE_PRESENT)))
+            continue;
+        ack = dap_ap_begin((uint8_t)ap);
+        if (ack == DAP_TRANSFER_OK)
+            topo_component((uint8_t)ap, base & CS_ROM_ENTRY_OFFSET, 0);
+        dap_ap_end();
+    }
+    topo.valid = true;
+}
+
+/**
+ * @brief Drop the topology cache, called on connect and line reset.
+ *
+ * @return None.
+ */
+void dap_vendor_topology_reset(void)
+{
+    topo.valid = false;
+}
+
+/**
+ * @brief DAP vendor topology discovery, the probe scans the APs and walks the ROM tables
+ *        in one go, the result is cached until the next connect or line reset.
+ *        discover : force, AP num (0 : 16), read : offset of the blob.
+ *        An ADIv6 target answers DAP_ERROR with the ADIv6 flag and only the DP record.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_topology(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t offset, len;
+
+    switch (request[0])
+    {
+        case TOPO_DISCOVER:
+            {
+                if (remaining_size < TOPO_DISCOVER_RESP_SIZE)
+                    return 0;
+                if (request[1] || !topo.valid)
+                    topo_discover(request[2] ? request[2] : TOPO_AP_NUM_DEFAULT);
+                response[0] = (topo.valid && !topo.adiv6) ? DAP_OK : DAP_ERROR;
+                response[1] = (topo.valid ? TOPO_FLAG_VALID : 0) | (topo.truncated ? TOPO_FLAG_TRUNCATED : 0)
+                            | (topo.adiv6 ? TOPO_FLAG_ADIV6 : 0);
+                __UNALIGNED_UINT16_WRITE(response + 2, topo.len);
+                response[4] = topo.ap_cnt;
+                response[5] = topo.comp_cnt;
+            }
+            return (TOPO_DISCOVER_RESP_SIZE << 16) | TOPO_DISCOVER_SIZE;
+        case TOPO_READ:
+            {
+                if (remaining_size < TOPO_READ_HEAD_SIZE)
+                    return 0;
+                offset = __UNALIGNED_UINT16_READ(request + 1);
+                len = 0;
+                if (topo.valid && (offset < topo.len))
+                    len = MIN(topo.len - offset, remaining_size - TOPO_READ_HEAD_SIZE);
+                response[0] = topo.valid ? DAP_OK : DAP_ERROR;
+                __UNALIGNED_UINT16_WRITE(response + 1, (uint16_t)len);
+                rt_memcpy(response + TOPO_READ_HEAD_SIZE, &topo.blob[offset], len);
+            }
+            return ((TOPO_READ_HEAD_SIZE + len) << 16) | 3U;
+        default:
+            break;
+    }
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief DAP vendor SWD multi-drop targets, the probe keeps a TARGETSEL table and switches
+ *        targets with the minimal line reset, TARGETSEL, DPIDR sequence.
+ *        config : count, TARGETSEL of each target, switch : index, returns DPIDR.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_swd_target(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+#if (DAP_SWD != 0)
+    uint32_t req_len, dpidr = 0;
+
+    switch (request[0])
+    {
+        case SWD_TARGET_CONFIG:
+            {
+                req_len = SWD_TARGET_CONFIG_HEAD_SIZE + request[1] * 4U;
+                if (req_len > DAP_PACKET_SIZE)
+                {
+                    response[0] = DAP_ERROR;
+                    return (1U << 16) | SWD_TARGET_CONFIG_HEAD_SIZE;
+                }
+                response[0] = dap_swd_target_config(request + SWD_TARGET_CONFIG_HEAD_SIZE, request[1]);
+            }
+            return (1U << 16) | req_len;
+        case SWD_TARGET_SWITCH:
+            {
+                if (remaining_size < SWD_TARGET_SWITCH_RESP_SIZE)
+                    return 0;
+                response[0] = (dap_swd_target_switch(request[1], &dpidr) == DAP_TRANSFER_OK) ? DAP_OK : DAP_ERROR;
+                __UNALIGNED_UINT32_WRITE(response + 1, dpidr);
+            }
+            return (SWD_TARGET_SWITCH_RESP_SIZE << 16) | 2U;
+        default:
+            break;
+    }
+#endif
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief DAP vendor JTAG scan chain detection, the probe counts the TAPs in BYPASS, reads
+ *        the IDCODEs and splits the IR capture, apply sets the chain as JTAG_Configure.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_jtag_detect(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint8_t ir_length[DAP_JTAG_DEV_CNT];
+    uint32_t idcode[DAP_JTAG_DEV_CNT];
+    uint16_t ir_total;
+    uint8_t count, *p;
+
+    if (remaining_size < JTAG_DETECT_HEAD_SIZE + DAP_JTAG_DEV_CNT * JTAG_DETECT_DEV_SIZE)
+        return 0;
+
+    response[0] = dap_jtag_chain_detect(request[0], ir_length, idcode, &count, &ir_total);
+    response[1] = count;
+    __UNALIGNED_UINT16_WRITE(response + 2, ir_total);
+    p = response + JTAG_DETECT_HEAD_SIZE;
+    for (uint32_t n = 0; n < count; n++)
+    {
+        /* IR length is only known when the split succeeded */
+        p[0] = (response[0] == JTAG_DETECT_OK) ? ir_length[n] : 0;
+        __UNALIGNED_UINT32_WRITE(p + 1, idcode[n]);
+        p += JTAG_DETECT_DEV_SIZE;
+    }
+
+    return ((JTAG_DETECT_HEAD_SIZE + count * JTAG_DETECT_DEV_SIZE) << 16) | JTAG_DETECT_SIZE;
+}
+
+#if (DAP_JTAG != 0)
+/**
+ * @brief RISC-V wait for the abstract command, cmderr is cleared in the debug module.
+ *
+ * @param cmderr            A pointer to the cmderr of the command.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t riscv_abstract_wait(uint32_t *cmderr)
+{
+    uint32_t cs, retry = RISCV_ABSTRACT_RETRY;
+    uint8_t ack;
+
+    do
+    {
+        ack = dap_riscv_dmi_read(DM_ABSTRACTCS, &cs);
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+    } while ((cs & ABSTRACTCS_BUSY) && (--retry));
+    if (cs & ABSTRACTCS_BUSY)
+        return DAP_TRANSFER_ERROR;
+
+    *cmderr = ABSTRACTCS_CMDERR(cs);
+    if (*cmderr)
+        ack = dap_riscv_dmi_write(DM_ABSTRACTCS, ABSTRACTCS_CMDERR_CLR);
+    return ack;
+}
+
+/**
+ * @brief RISC-V run an abstract command and wait for it.
+ *
+ * @param command           Command value.
+ * @param cmderr            A pointer to the cmderr of the command.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t riscv_abstract_cmd(uint32_t command, uint32_t *cmderr)
+{
+    uint8_t ack = dap_riscv_dmi_write(DM_COMMAND, command);
+
+    if (ack == DAP_TRANSFER_OK)
+        ack = riscv_abstract_wait(cmderr);
+    return ack;
+}
+
+/**
+ * @brief RISC-V access a register by the access register abstract command, data0 and data1
+ *        carry the value.
+ *
+ * @param aarsize           AARSIZE_32 or AARSIZE_64.
+ * @param regno             Register num.
+ * @param data              A pointer to the value, no alignment needed.
+ * @param flags             AC_WRITE, AC_POSTEXEC.
+ * @param cmderr            A pointer to the cmderr of the command.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t riscv_reg_transfer(uint32_t aarsize, uint32_t regno, uint8_t *data, uint32_t flags, uint32_t *cmderr)
+{
+    uint32_t value;
+    uint8_t ack = DAP_TRANSFER_OK;
+
+    if (flags & AC_WRITE)
+    {
+        ack = dap_riscv_dmi_write(DM_DATA0, __UNALIGNED_UINT32_READ(data));
+        if ((ack == DAP_TRANSFER_OK) && (aarsize == AARSIZE_64))
+            ack = dap_riscv_dmi_write(DM_DATA1, __UNALIGNED_UINT32_READ(data + 4));
+        if (ack != DAP_TRANSFER_OK)
+            return ack;
+    }
+    ack = riscv_abstract_cmd(AC_ACCESS_REG(aarsize, regno) | AC_TRANSFER | flags, cmderr);
+    if ((ack != DAP_TRANSFER_OK) || *cmderr || (flags & AC_WRITE))
+        return ack;
+
+    ack = dap_riscv_dmi_read(DM_DATA0, &value);
+    __UNALIGNED_UINT32_WRITE(data, value);
+    if ((ack == DAP_TRANSFER_OK) && (aarsize == AARSIZE_64))
+    {
+        ack = dap_riscv_dmi_read(DM_DATA1, &value);
+        __UNALIGNED_UINT32_WRITE(data + 4, value);
+    }
+    return ack;
+}
+
+/**
+ * @brief RISC-V load the program buffer of a memory loop: access, addi s0, s0, 4, ebreak.
+ *
+ * @param insn              Load or store instruction.
+ * @param cmderr            A pointer to the cmderr, CMDERR_NOT_SUPPORTED if the buffer is too small.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t riscv_progbuf_load(uint32_t insn, uint32_t *cmderr)
+{
+    uint32_t cs, dmstatus, size;
+    uint8_t ack;
+
+    ack = dap_riscv_dmi_read(DM_ABSTRACTCS, &cs);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_riscv_dmi_read(DM_DMSTATUS, &dmstatus);
+    if (ack != DAP_TRANSFER_OK)
+        return ack;
+
+    size = ABSTRACTCS_PROGBUFSIZE(cs);
+    if ((size < 2U) || ((size < 3U) && !(dmstatus & DMSTATUS_IMPEBREAK)))
+    {
+        *cmderr = CMDERR_NOT_SUPPORTED;
+        return DAP_TRANSFER_OK;
+    }
+    ack = dap_riscv_dmi_write(DM_PROGBUF0, insn);
+    if (ack == DAP_TRANSFER_OK)
+        ack = dap_riscv_dmi_write(DM_PROGBUF0 + 1U, RV_ADDI_S0_4);
+    if ((ack == DAP_TRANSFER_OK) && (size >= 3U))
+        ack = dap_riscv_dmi_write(DM_PROGBUF0 + 2U, RV_EBREAK);
+    return ack;
+}
+
+/**
+ * @brief RISC-V read memory words by the program buffer, data0 is read with autoexec
+ *        so each word costs one DMI scan. The loop stops one load short of the end,
+ *        nothing past the range is read.
+ *
+ * @param aarsize           Size of s0.
+ * @param addr              Target address, word aligned.
+ * @param data              A pointer to the data read, no alignment needed.
+ * @param cnt               Num of words, not 0.
+ * @param cmderr            A pointer to the cmderr.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t riscv_mem_read_run(uint32_t aarsize, uint32_t addr, uint8_t *data, uint32_t cnt, uint32_t *cmderr)
+{
+    uint8_t start[8] = {0};
+    uint32_t value;
+    uint8_t ack, ack_auto;
+
+    // s0 = addr, s1 = word 0
+    __UNALIGNED_UINT32_WRITE(start, addr);
+    ack = riscv_reg_transfer(aarsize, RISCV_REG_S0, start, AC_WRITE | AC_POSTEXEC, cmderr);
+    if ((ack == DAP_TRANSFER_OK) && !*cmderr && (cnt > 1U))
+    {
+        // data0 = word 0, s1 = word 1
+        ack = riscv_abstract_cmd(AC_ACCESS_REG(AARSIZE_32, RISCV_REG_S1) | AC_TRANSFER | AC_POSTEXEC, cmderr);
+        if ((ack == DAP_TRANSFER_OK) && !*cmderr && (cnt > 2U))
+        {
+            // each data0 read returns word n and loads word n + 2
+            ack = dap_riscv_dmi_write(DM_ABSTRACTAUTO, ABSTRACTAUTO_DATA0);
+            if (ack == DAP_TRANSFER_OK)
+                ack = dap_riscv_dmi_read_repeat(DM_DATA0, data, cnt - 2U);
+            ack_auto = dap_riscv_dmi_write(DM_ABSTRACTAUTO, 0);
+            if (ack == DAP_TRANSFER_OK)
+                ack = ack_auto;
+            if (ack == DAP_TRANSFER_OK)
+                ack = riscv_abstract_wait(cmderr);
+            data += (cnt - 2U) << 2;
+        }
+        if ((ack == DAP_TRANSFER_OK) && !*cmderr)
+        {
+            ack = dap_riscv_dmi_read(DM_DATA0, &value);
+            __UNALIGNED_UINT32_WRITE(data, value);
+            data += 4;
+        }
+    }
+    // data0 = last word
+    if ((ack == DAP_TRANSFER_OK) && !*cmderr)
+        ack = riscv_reg_transfer(AARSIZE_32, RISCV_REG_S1, data, 0, cmderr);
+    return ack;
+}
+
+/**
+ * @brief RISC-V write memory words by the program buffer, data0 is written with autoexec
+ *        so each word costs one DMI scan.
+ *
+ * @param aarsize           Size of s0.
+ * @param addr              Target address, word aligned.
+ * @param data              A pointer to the data written, no alignment needed.
+ * @param cnt               Num of words, not 0.
+ * @param cmderr            A pointer to the cmderr.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t riscv_mem_write_run(uint32_t aarsize, uint32_t addr, uint8_t *data, uint32_t cnt, uint32_t *cmderr)
+{
+    uint8_t start[8] = {0};
+    uint8_t ack, ack_auto;
+
+    // s0 = addr, then word 0 is stored
+    __UNALIGNED_UINT32_WRITE(start, addr);
+    ack = riscv_reg_transfer(aarsize, RISCV_REG_S0, start, AC_WRITE, cmderr);
+    if ((ack == DAP_TRANSFER_OK) && !*cmderr)
+        ack = riscv_reg_transfer(AARSIZE_32, RISCV_REG_S1, data, AC_WRITE | AC_POSTEXEC, cmderr);
+    if ((ack == DAP_TRANSFER_OK) && !*cmderr && (cnt > 1U))
+    {
+        // each data0 write stores the next word
+        ack = dap_riscv_dmi_write(DM_ABSTRACTAUTO, ABSTRACTAUTO_DATA0);
+        if (ack == DAP_TRANSFER_OK)
+            ack = dap_riscv_dmi_write_repeat(DM_DATA0, data + 4, cnt - 1U);
+        ack_auto = dap_riscv_dmi_write(DM_ABSTRACTAUTO, 0);
+        if (ack == DAP_TRANSFER_OK)
+            ack = ack_auto;
+        if (ack == DAP_TRANSFER_OK)
+            ack = riscv_abstract_wait(cmderr);
+    }
+    return ack;
+}
+
+/**
+ * @brief RISC-V memory access by the program buffer, s0 and s1 are saved and restored.
+ *        A busy DMI or abstract command restarts the loop with more idle cycles.
+ *        The hart must be halted.
+ *
+ * @param write             Write memory.
+ * @param aarsize           AARSIZE_32 or AARSIZE_64, XLEN of the hart.
+ * @param addr              Target address, word aligned.
+ * @param data              A pointer to the data, no alignment needed.
+ * @param cnt               Num of words, not 0.
+ * @param cmderr            A pointer to the cmderr.
+ *
+ * @return Ack of transfer.
+ */
+static uint8_t riscv_mem_access(uint8_t write, uint32_t aarsize, uint32_t addr, uint8_t *data, uint32_t cnt, uint32_t *cmderr)
+{
+    uint8_t save[16];
+    uint32_t retry = 0, restore_err = 0;
+    uint8_t ack, restore_ack;
+
+    ack = riscv_progbuf_load(write ? RV_SW_S1_S0 : RV_LW_S1_S0, cmderr);
+    if ((ack == DAP_TRANSFER_OK) && !*cmderr)
+        ack = riscv_reg_transfer(aarsize, RISCV_REG_S0, save, 0, cmderr);
+    if ((ack == DAP_TRANSFER_OK) && !*cmderr)
+        ack = riscv_reg_transfer(aarsize, RISCV_REG_S1, save + 8, 0, cmderr);
+    if ((ack != DAP_TRANSFER_OK) || *cmderr)
+        return ack;
+
+    do
+    {
+        if (*cmderr == CMDERR_BUSY)
+            dap_riscv_dtm_backoff();
+        *cmderr = 0;
+        if (write)
+            ack = riscv_mem_write_run(aarsize, addr, data, cnt, cmderr);
+        else
+            ack = riscv_mem_read_run(aarsize, addr, data, cnt, cmderr);
+    } while (((ack == DAP_TRANSFER_WAIT) || (*cmderr == CMDERR_BUSY)) && (retry++ < RISCV_MEM_RETRY));
+
+    restore_ack = riscv_reg_transfer(aarsize, RISCV_REG_S0, save, AC_WRITE, &restore_err);
+    if ((restore_ack == DAP_TRANSFER_OK) && !restore_err)
+        restore_ack = riscv_reg_transfer(aarsize, RISCV_REG_S1, save + 8, AC_WRITE, &restore_err);
+    if ((ack == DAP_TRANSFER_OK) && !*cmderr)
+    {
+        ack = restore_ack;
+        *cmderr = restore_err;
+    }
+    return ack;
+}
+#endif
+
+/**
+ * @brief DAP vendor RISC-V debug over JTAG, DMI accesses with busy retry, abstract register
+ *        and program buffer memory accesses run on the probe. The acks are DAP transfer acks.
+ *        select : JTAG index, flags, DMI batch : count, op, address, data of writes,
+ *        register : write, aarsize, count, regno, data of writes,
+ *        memory : aarsize, address, count of words, data of writes.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_riscv(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+#if (DAP_JTAG != 0)
+    uint32_t req_len, resp_len, cnt, size, data, done = 0, cmderr = 0;
+    uint8_t ack = DAP_TRANSFER_OK, write, valid, *p;
+
+    switch (request[0])
+    {
+        case RISCV_DTM_SELECT:
+            {
+                if (remaining_size < RISCV_SELECT_RESP_SIZE)
+                    return 0;
+                response[0] = dap_riscv_dtm_select(request[1], request[2] & RISCV_SELECT_HARD_RESET, &data);
+                __UNALIGNED_UINT32_WRITE(response + 1, data);
+            }
+            return (RISCV_SELECT_RESP_SIZE << 16) | RISCV_SELECT_SIZE;
+        case RISCV_DMI_BATCH:
+            {
+                cnt = request[1];
+                req_len = RISCV_DMI_HEAD_SIZE;
+                resp_len = RISCV_DMI_HEAD_SIZE;
+                valid = true;
+                /* the request follows the command byte, DAP_PACKET_SIZE - 1 bytes at most */
+                for (uint32_t n = 0; (n < cnt) && valid; n++)
+                {
+                    if ((req_len + RISCV_DMI_OP_SIZE) > (DAP_PACKET_SIZE - 1U))
+                        valid = false;
+                    else if (request[req_len] == RISCV_DMI_READ)
+                    {
+                        req_len += RISCV_DMI_OP_SIZE;
+                        resp_len += 4U;
+                    }
+                    else if ((request[req_len] == RISCV_DMI_WRITE) && ((req_len + RISCV_DMI_OP_SIZE + 4U) <= (DAP_PACKET_SIZE - 1U)))
+                        req_len += RISCV_DMI_OP_SIZE + 4U;
+                    else
+                        valid = false;
+                }
+                if (!valid || (remaining_size < resp_len))
+                {
+                    response[0] = DAP_TRANSFER_ERROR;
+                    response[1] = 0;
+                    return (RISCV_DMI_HEAD_SIZE << 16) | req_len;
+                }
+
+                p = request + RISCV_DMI_HEAD_SIZE;
+                resp_len = RISCV_DMI_HEAD_SIZE;
+                while ((done < cnt) && (ack == DAP_TRANSFER_OK))
+                {
+                    if (p[0] == RISCV_DMI_WRITE)
+                    {
+                        ack = dap_riscv_dmi_write(__UNALIGNED_UINT32_READ(p + 1), __UNALIGNED_UINT32_READ(p + 5));
+                        p += RISCV_DMI_OP_SIZE + 4U;
+                    }
+                    else if (p[0] == RISCV_DMI_READ)
+                    {
+                        ack = dap_riscv_dmi_read(__UNALIGNED_UINT32_READ(p + 1), &data);
+                        __UNALIGNED_UINT32_WRITE(response + resp_len, data);
+                        resp_len += (ack == DAP_TRANSFER_OK) ? 4U : 0;
+                        p += RISCV_DMI_OP_SIZE;
+                    }
+                    else
+                    {
+                        ack = DAP_TRANSFER_ERROR;
+                    }
+                    if (ack == DAP_TRANSFER_OK)
+                        done++;
+                }
+                response[0] = ack;
+                response[1] = (uint8_t)done;
+            }
+            return (resp_len << 16) | req_len;
+        case RISCV_REG_ACCESS:
+            {
+                write = request[1];
+                size = (request[2] == AARSIZE_64) ? 8U : 4U;
+                cnt = request[3];
+                req_len = RISCV_REG_HEAD_SIZE + cnt * (2U + (write ? size : 0));
+                resp_len = RISCV_RESP_HEAD_SIZE + (write ? 0 : cnt * size);
+                if ((req_len > (DAP_PACKET_SIZE - 1U)) || (remaining_size < resp_len)
+                    || ((request[2] != AARSIZE_32) && (request[2] != AARSIZE_64)))
+                {
+                    response[0] = DAP_TRANSFER_ERROR;
+                    response[1] = 0;
+                    response[2] = 0;
+                    return (RISCV_RESP_HEAD_SIZE << 16) | MIN(req_len, DAP_PACKET_SIZE - 1U);
+                }
+
+                p = request + RISCV_REG_HEAD_SIZE;
+                while ((done < cnt) && (ack == DAP_TRANSFER_OK) && !cmderr)
+                {
+                    ack = riscv_reg_transfer(request[2], __UNALIGNED_UINT16_READ(p),
+                                             write ? (p + 2) : (response + RISCV_RESP_HEAD_SIZE + done * size),
+                                             write ? AC_WRITE : 0, &cmderr);
+                    p += 2U + (write ? size : 0);
+                    if ((ack == DAP_TRANSFER_OK) && !cmderr)
+                        done++;
+                }
+                response[0] = ack;
+                response[1] = (uint8_t)cmderr;
+                response[2] = (uint8_t)done;
+            }
+            return ((RISCV_RESP_HEAD_SIZE + (write ? 0 : done * size)) << 16) | req_len;
+        case RISCV_MEM_READ:
+        case RISCV_MEM_WRITE:
+            {
+                write = (request[0] == RISCV_MEM_WRITE);
+                cnt = request[6];
+                req_len = RISCV_MEM_HEAD_SIZE + (write ? (cnt << 2) : 0);
+                resp_len = RISCV_RESP_HEAD_SIZE + (write ? 0 : (cnt << 2));
+                if ((req_len > (DAP_PACKET_SIZE - 1U)) || (remaining_size < resp_len) || !cnt
+                    || ((request[1] != AARSIZE_32) && (request[1] != AARSIZE_64))
+                    || (__UNALIGNED_UINT32_READ(request + 2) & 0x3U))
+                {
+                    response[0] = DAP_TRANSFER_ERROR;
+                    response[1] = 0;
+                    response[2] = 0;
+                    return (RISCV_RESP_HEAD_SIZE << 16) | MIN(req_len, DAP_PACKET_SIZE - 1U);
+                }
+
+                ack = riscv_mem_access(write, request[1], __UNALIGNED_UINT32_READ(request + 2),
+                                       write ? (request + RISCV_MEM_HEAD_SIZE) : (response + RISCV_RESP_HEAD_SIZE),
+                                       cnt, &cmderr);
+                if ((ack == DAP_TRANSFER_OK) && !cmderr)
+                    done = cnt;
+                response[0] = ack;
+                response[1] = (uint8_t)cmderr;
+                response[2] = (uint8_t)done;
+            }
+            return ((RISCV_RESP_HEAD_SIZE + (write ? 0 : (done << 2))) << 16) | req_len;
+        default:
+            break;
+    }
+#endif
+
+    response[0] = DAP_TRANSFER_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief Boundary scan burst, shifts the boundary register each interval and queues
+ *        a timestamped record until the burst time is used up.
+ *
+ * @param request_pending   Return 1 if the host has a request waiting.
+ *
+ * @return Wait ticks before the next burst.
+ */
+static int32_t bscan_poll(uint8_t (*request_pending)(void))
+{
+    uint32_t start = dap_get_cur_tick();
+    uint32_t stamp;
+    uint8_t *record;
+    int32_t wait = 0;
+
+    if (!bscan.active)
+        return RT_WAITING_FOREVER;
+
+    /* host transfers between bursts may have loaded another IR */
+    if (dap_jtag_dev_ir(bscan.index, bscan.ir) != DAP_TRANSFER_OK)
+    {
+        bscan.active = false;
+        return RT_WAITING_FOREVER;
+    }
+
+    /* samples missed between bursts are not made up */
+    if ((int32_t)(start - bscan.next) > 0)
+        bscan.next = start;
+
+    while (!dap_wait_us_noblock(start, DAP_SERVICE_BURST_US))
+    {
+        if (request_pending())
+            break;
+        if (!dap_service_due(&bscan.next, bscan.interval, &wait))
+        {
+            if (wait)
+                break;
+            continue;
+        }
+
+        stamp = dap_get_cur_tick();
+        dap_jtag_dev_dr(bscan.index, bscan.bits, bscan.tdi, bscan.tdo);
+        if (bscan.bits & 0x7U)
+            bscan.tdo[bscan.bytes - 1U] &= (1U << (bscan.bits & 0x7U)) - 1U;
+        bscan.samples++;
+
+        if ((bscan.flags & BSCAN_FLAG_CHANGES) && bscan.queued
+            && (rt_memcmp(bscan.tdo, bscan.last, bscan.bytes) == 0))
+            continue;
+        /* the last sample is kept so a dropped change is queued again later */
+        if ((record = record_ring_slot(&bscan.ring)) == NULL)
+        {
+            bscan.dropped++;
+            continue;
+        }
+        __UNALIGNED_UINT32_WRITE(record, stamp);
+        rt_memcpy(record + BSCAN_STAMP_SIZE, bscan.tdo, bscan.bytes);
+        rt_memcpy(bscan.last, bscan.tdo, bscan.bytes);
+        record_ring_push(&bscan.ring);
+        bscan.queued++;
+    }
+
+    if (request_pending())
+        return 0;
+    return wait ? wait : 1;
+}
+
+/**
+ * @brief Boundary scan stream drain, called by the DAP thread when the host side can take data.
+ *        Only whole records are returned.
+ *
+ * @param buf               A pointer to the data buffer.
+ * @param size              Size of the data buffer.
+ *
+ * @return Len of data.
+ */
+uint16_t dap_vendor_bscan_read(uint8_t *buf, uint16_t size)
+{
+    return (uint16_t)(record_ring_pop(&bscan.ring, buf, size) * bscan.ring.record_size);
+}
+
+/**
+ * @brief DAP vendor boundary scan sampling, the probe loads SAMPLE/PRELOAD or EXTEST into
+ *        a JTAG device and streams the boundary register on the RTT interface.
+ *        start : JTAG index, IR, boundary bits, rate(Hz, 0 : max), flags, TDI pattern,
+ *        stop, status.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_bscan(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+    uint32_t bits, rate, req_len;
+
+    switch (request[0])
+    {
+        case BSCAN_START:
+            {
+                bits = __UNALIGNED_UINT16_READ(request + 6);
+                rate = __UNALIGNED_UINT32_READ(request + 8);
+                req_len = BSCAN_START_HEAD_SIZE + ((bits + 7U) >> 3);
+                rt_memset(&bscan, 0, sizeof(bscan_info_t));
+                if (!bits || (bits > BSCAN_BITS_MAX) || (req_len > (DAP_PACKET_SIZE - 1U)) || dap_vendor_rtt_active())
+                {
+                    response[0] = DAP_ERROR;
+                    return (1U << 16) | MIN(req_len, DAP_PACKET_SIZE - 1U);
+                }
+                bscan.index = request[1];
+                bscan.ir = __UNALIGNED_UINT32_READ(request + 2);
+                bscan.bits = bits;
+                bscan.bytes = (bits + 7U) >> 3;
+                bscan.flags = request[12];
+                bscan.interval = rate ? (SystemCoreClock / rate) : 0;
+                bscan.next = dap_get_cur_tick();
+                record_ring_init(&bscan.ring, bscan.buffer, BSCAN_BUF_SIZE, BSCAN_STAMP_SIZE + bscan.bytes);
+                rt_memcpy(bscan.tdi, request + BSCAN_START_HEAD_SIZE, bscan.bytes);
+                bscan.active = (dap_jtag_dev_ir(bscan.index, bscan.ir) == DAP_TRANSFER_OK);
+                response[0] = bscan.active ? DAP_OK : DAP_ERROR;
+            }
+            return (1U << 16) | req_len;
+        case BSCAN_STOP:
+            {
+                bscan.active = false;
+                response[0] = DAP_OK;
+            }
+            return (1U << 16) | 1U;
+        case BSCAN_STATUS:
+            {
+                if (remaining_size < BSCAN_STATUS_SIZE)
+                    return 0;
+                response[0] = DAP_OK;
+                response[1] = bscan.active;
+                __UNALIGNED_UINT32_WRITE(response + 2, bscan.samples);
+                __UNALIGNED_UINT32_WRITE(response + 6, bscan.queued);
+                __UNALIGNED_UINT32_WRITE(response + 10, bscan.dropped);
+            }
+            return (BSCAN_STATUS_SIZE << 16) | 1U;
+        default:
+            break;
+    }
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+#if (DAP_JTAG != 0)
+/**
+ * @brief SVF wait until at least the time from the start tick has passed, long waits
+ *        give the CPU to other threads.
+ *
+ * @param start             DWT cycle count the wait starts from.
+ * @param us                Wait time in us.
+ *
+ * @return None.
+ */
+static void svf_wait(uint32_t start, uint32_t us)
+{
+    uint32_t part, elapsed;
+
+    while (us)
+    {
+        part = MIN(us, HRTIMER_MAX_US);
+        if (part >= SVF_YIELD_US)
+        {
+            elapsed = (dap_get_cur_tick() - start) / (SystemCoreClock / 1000000U);
+            if (elapsed < part)
+                dap_hrtimer_sleep(part - elapsed);
+        }
+        while (!dap_wait_us_noblock(start, part));
+        start += part * (SystemCoreClock / 1000000U);
+        us -= part;
+    }
+}
+
+/**
+ * @brief SVF SIR/SDR chunk, TDO is compared under the mask and only the first
+ *        mismatching bit is kept. With SVF_SCAN_RETRY a mismatch is retried as
+ *        XSVF does: Pause, Shift, Run-Test/Idle, wait 25% longer and scan again.
+ *
+ * @param op                A pointer to the operation.
+ * @param size              Len of the payload left.
+ *
+ * @return Len of the operation, 0 if malformed.
+ */
+static uint32_t svf_scan(const uint8_t *op, uint32_t size)
+{
+    uint32_t flags = op[1];
+    uint32_t end = op[2];
+    uint32_t bits, bytes, head, len, i, diff;
+    uint32_t repeat = 0, wait = 0, mismatch;
+    uint32_t shift = (op[0] == SVF_OP_SIR) ? JTAG_TAP_IRSHIFT : JTAG_TAP_DRSHIFT;
+    const uint8_t *tdi, *tdo, *mask;
+
+    if (size < SVF_SCAN_HEAD_SIZE)
+        return 0;
+    bits = __UNALIGNED_UINT16_READ(op + 3);
+    bytes = (bits + 7U) >> 3;
+    head = SVF_SCAN_HEAD_SIZE;
+    if (flags & SVF_SCAN_RETRY)
+    {
+        if ((size < (head + SVF_RETRY_SIZE)) || ((flags & (SVF_SCAN_FIRST | SVF_SCAN_LAST)) != (SVF_SCAN_FIRST | SVF_SCAN_LAST)))
+            return 0;
+        repeat = op[head];
+        wait = __UNALIGNED_UINT32_READ(op + head + 1);
+        head += SVF_RETRY_SIZE;
+    }
+    len = head + bytes * ((flags & SVF_SCAN_COMPARE) ? 3U : 1U);
+    if (!bits || (bits > SVF_CHUNK_BITS) || (len > size) || (end >= JTAG_TAP_STATES)
+        || (!(flags & SVF_SCAN_FIRST) && (svf.state != shift)))
+        return 0;
+    tdi = op + head;
+    tdo = tdi + bytes;
+    mask = tdo + bytes;
+
+    for (;;)
+    {
+        if (flags & SVF_SCAN_FIRST)
+        {
+            svf.state = dap_jtag_tap_move(svf.state, shift);
+            svf.scan_bit = 0;
+        }
+        dap_jtag_tap_shift(bits, flags & SVF_SCAN_LAST, (uint8_t *)tdi, svf.tdo);
+        if (flags & SVF_SCAN_LAST)
+            svf.state = shift + 1U;
+
+        mismatch = false;
+        for (i = 0; (flags & SVF_SCAN_COMPARE) && (i < bytes); i++)
+        {
+            diff = (svf.tdo[i] ^ tdo[i]) & mask[i];
+            if ((i == (bytes - 1U)) && (bits & 0x7U))
+                diff &= (1U << (bits & 0x7U)) - 1U;
+            if (diff)
+            {
+                for (svf.fail_bit = svf.scan_bit + (i << 3); !(diff & 0x1U); diff >>= 1)
+                    svf.fail_bit++;
+                mismatch = true;
+                break;
+            }
+        }
+        if (!mismatch || !repeat)
+            break;
+
+        // Exit1, Pause, Exit2, Shift, Exit1, Update, Run-Test/Idle
+        repeat--;
+        svf.state = dap_jtag_tap_move(svf.state, shift + 2U);
+        svf.state = dap_jtag_tap_move(svf.state, shift);
+        svf.state = dap_jtag_tap_move(svf.state, JTAG_TAP_IDLE);
+        wait += wait >> 2;
+        svf_wait(dap_get_cur_tick(), wait);
+    }
+
+    if (flags & SVF_SCAN_LAST)
+    {
+        svf.state = dap_jtag_tap_move(svf.state, end);
+        svf_wait(dap_get_cur_tick(), wait);
+        if (!mismatch)
+            svf.scan++;
+    }
+    else
+    {
+        svf.scan_bit += bits;
+    }
+    if (mismatch)
+        svf.result = SVF_RESULT_MISMATCH;
+    return len;
+}
+
+/**
+ * @brief SVF run one operation.
+ *
+ * @param op                A pointer to the operation.
+ * @param size              Len of the payload left.
+ *
+ * @return Len of the operation, 0 if malformed.
+ */
+static uint32_t svf_op(const uint8_t *op, uint32_t size)
+{
+    uint32_t start, last, cnt, n;
+
+    switch (op[0])
+    {
+        case SVF_OP_STATE:
+            {
+                if ((size < SVF_STATE_SIZE) || (op[1] >= JTAG_TAP_STATES))
+                    return 0;
+                svf.state = dap_jtag_tap_move(svf.state, op[1]);
+            }
+            return SVF_STATE_SIZE;
+        case SVF_OP_SIR:
+        case SVF_OP_SDR:
+            return svf_scan(op, size);
+        case SVF_OP_RUNTEST:
+            {
+                if ((size < SVF_RUNTEST_SIZE) || (op[1] >= JTAG_TAP_STATES) || (op[2] >= JTAG_TAP_STATES))
+                    return 0;
+                svf.state = dap_jtag_tap_move(svf.state, op[1]);
+                start = dap_get_cur_tick();
+                last = start;
+                /* long runs at slow clocks give the CPU away, the idle thread feeds the watchdog */
+                for (cnt = __UNALIGNED_UINT32_READ(op + 3); cnt; cnt -= n)
+                {
+                    n = MIN(cnt, SVF_CLOCK_SLICE);
+                    dap_jtag_tap_clock(n, svf.state == JTAG_TAP_RESET);
+                    if (dap_wait_us_noblock(last, SVF_YIELD_US))
+                    {
+                        rt_thread_mdelay(1);
+                        last = dap_get_cur_tick();
+                    }
+                }
+                svf_wait(start, __UNALIGNED_UINT32_READ(op + 7));
+                svf.state = dap_jtag_tap_move(svf.state, op[2]);
+            }
+            return SVF_RUNTEST_SIZE;
+        case SVF_OP_TRST:
+            {
+                if ((size < SVF_TRST_SIZE) || (op[1] > SVF_TRST_ABSENT))
+                    return 0;
+                if (op[1] == SVF_TRST_Z)
+                {
+                    DAP_TRST_TO_AIN();
+                }
+                else if (op[1] != SVF_TRST_ABSENT)
+                {
+                    DAP_TRST_TO_OPP();
+                    if (op[1] == SVF_TRST_ON)
+                    {
+                        DAP_TRST_TO_LOW();
+                        svf.state = JTAG_TAP_RESET;
+                    }
+                    else
+                    {
+                        DAP_TRST_TO_HIGH();
+                    }
+                }
+            }
+            return SVF_TRST_SIZE;
+        default:
+            break;
+    }
+    return 0;
+}
+#endif
+
+/**
+ * @brief DAP vendor SVF/XSVF player, the host streams operations converted by tools/svf_pack
+ *        and only the first error is reported, so a programming file is transfer-bound
+ *        instead of taking one round trip per scan.
+ *        reset : start a session, the TAP is reset by the first move,
+ *        exec  : payload len, operations; a session that failed skips them.
+ *
+ * @param request           A pointer to the request message.
+ * @param response          A pointer to the response message.
+ * @param remaining_size    Len of remain response buffer.
+ *
+ * @return Len of response message.
+ */
+static uint32_t dap_vendor_svf(uint8_t* request, uint8_t* response, uint16_t remaining_size)
+{
+#if (DAP_JTAG != 0)
+    uint32_t len, pos = 0, used;
+
+    switch (request[0])
+    {
+        case SVF_RESET:
+            {
+                /* the sampler would load its IR between packets */
+                bscan.active = false;
+                rt_memset(&svf, 0, sizeof(svf_info_t));
+                svf.state = JTAG_TAP_UNKNOWN;
+                response[0] = (dap_jtag_tap_begin() == DAP_TRANSFER_OK) ? DAP_OK : DAP_ERROR;
+            }
+            return (1U << 16) | 1U;
+        case SVF_EXEC:
+            {
+                if (remaining_size < SVF_RESP_SIZE)
+                    return 0;
+                len = __UNALIGNED_UINT16_READ(request + 1);
+                if ((SVF_EXEC_HEAD_SIZE + len) >= DAP_PACKET_SIZE)
+                {
+                    response[0] = DAP_ERROR;
+                    return (1U << 16) | SVF_EXEC_HEAD_SIZE;
+                }
+                response[0] = DAP_OK;
+                if ((svf.result == SVF_RESULT_OK) && len && (dap_jtag_tap_begin() != DAP_TRANSFER_OK))
+                    response[0] = DAP_ERROR;
+                while ((response[0] == DAP_OK) && (svf.result == SVF_RESULT_OK) && (pos < len))
+                {
+                    used = svf_op(request + SVF_EXEC_HEAD_SIZE + pos, len - pos);
+                    if (!used)
+                        svf.result = SVF_RESULT_BAD_OP;
+                    pos += used;
+                }
+                response[1] = svf.result;
+                __UNALIGNED_UINT32_WRITE(response + 2, svf.scan);
+                __UNALIGNED_UINT32_WRITE(response + 6, svf.fail_bit);
+            }
+            return (SVF_RESP_SIZE << 16) | (SVF_EXEC_HEAD_SIZE + len);
+        default:
+            break;
+    }
+#endif
+
+    response[0] = DAP_ERROR;
+    return (1U << 16) | 1U;
+}
+
+/**
+ * @brief DAP vendor notification waiting for sending on the notify endpoint.
+ *
+ * @param buf               A pointer to the notification buffer.
+ * @param size              Size of the notification buffer.
+ *
+ * @return Len of notification, 0 if none.
+ */
+uint16_t dap_vendor_notify_get(uint8_t *buf, uint16_t size)
+{
+    if ((!halt_watch.notify) || (size < HALT_NOTIFY_SIZE))
+        return 0;
+
+    buf[0] = HALT_NOTIFY_TYPE;
+    buf[1] = 0;
+    __UNALIGNED_UINT16_WRITE(buf + 2, halt_watch.halt_count);
+    __UNALIGNED_UINT32_WRITE(buf + 4, halt_watch.dhcsr);
+    halt_watch.notify = false;
+
+    return HALT_NOTIFY_SIZE;
+}
+
+/**
+ * @brief DAP vendor background services, run by the DAP thread between host requests.
+ *
+ * @param request_pending   Return 1 if the host has a request waiting.
+ *
+ * @return Wait ticks before the next call, RT_WAITING_FOREVER if no service is running.
+ */
+int32_t dap_vendor_service(uint8_t (*request_pending)(void))
+{
+    int32_t wait = RT_WAITING_FOREVER;
+
+    wait = dap_service_wait(wait, pc_sample_poll(request_pending));
+    wait = dap_service_wait(wait, halt_watch_poll());
+    wait = dap_service_wait(wait, rtt_poll());
+    wait = dap_service_wait(wait, var_watch_poll(request_pending));
+    wait = dap_service_wait(wait, bscan_poll(request_pending));
+
+    return wait;
+}
 
 /**
  * @brief DAP vendor request process.
@@ -76,21 +2871,51 @@ uint32_t dap_vendor_request_handler(uint8_t* request,
                 }   
             }        
             break;    
-        case ID_DAP_Vendor2: break;
-        case ID_DAP_Vendor3: break;
-        case ID_DAP_Vendor4: break;
-        case ID_DAP_Vendor5: break;
-        case ID_DAP_Vendor6: break;
-        case ID_DAP_Vendor7: break;
-        case ID_DAP_Vendor8: break;
-        case ID_DAP_Vendor9: break;
-        case ID_DAP_Vendor10: break;
-        case ID_DAP_Vendor11: break;
-        case ID_DAP_Vendor12: break;
-        case ID_DAP_Vendor13: break;    
-        case ID_DAP_Vendor14: break;
-        case ID_DAP_Vendor15: break;
-        case ID_DAP_Vendor16: break;
+        // thread statistics
+        case ID_DAP_Vendor2:
+            return dap_vendor_thread_stat(request, response, remaining_size);
+        // PC sampling profiler
+        case ID_DAP_Vendor3:
+            return dap_vendor_pc_sample(request, response, remaining_size);
+        // halt watcher
+        case ID_DAP_Vendor4:
+            return dap_vendor_halt_watch(request, response);
+        // core register access
+        case ID_DAP_Vendor5:
+            return dap_vendor_core_reg(request, response, remaining_size);
+        // target memory CRC
+        case ID_DAP_Vendor6:
+            return dap_vendor_mem_crc(request, response);
+        // block compare
+        case ID_DAP_Vendor7:
+            return dap_vendor_mem_compare(request, response, remaining_size);
+        // flash algorithm runner
+        case ID_DAP_Vendor8:
+            return dap_vendor_flash_algo(request, response, remaining_size);
+        // RTT streamer
+        case ID_DAP_Vendor9:
+            return dap_vendor_rtt(request, response, remaining_size);
+        // periodic variable sampling
+        case ID_DAP_Vendor10:
+            return dap_vendor_var_watch(request, response, remaining_size);
+        // AP and ROM table discovery
+        case ID_DAP_Vendor11:
+            return dap_vendor_topology(request, response, remaining_size);
+        // SWD multi-drop targets
+        case ID_DAP_Vendor12:
+            return dap_vendor_swd_target(request, response, remaining_size);
+        // JTAG scan chain detection
+        case ID_DAP_Vendor13:
+            return dap_vendor_jtag_detect(request, response, remaining_size);
+        // RISC-V debug over JTAG
+        case ID_DAP_Vendor14:
+            return dap_vendor_riscv(request, response, remaining_size);
+        // boundary scan sampling
+        case ID_DAP_Vendor15:
+            return dap_vendor_bscan(request, response, remaining_size);
+        // SVF/XSVF player
+        case ID_DAP_Vendor16:
+            return dap_vendor_svf(request, response, remaining_size);
         case ID_DAP_Vendor17: break;
         case ID_DAP_Vendor18: break;
         case ID_DAP_Vendor19: break;
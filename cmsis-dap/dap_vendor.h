@@ -10,6 +10,13 @@ extern "C" {
 
 extern uint32_t dap_vendor_request_handler(uint8_t* request,
         uint8_t* response, uint8_t cmd_id, uint16_t remaining_size);
+extern int32_t dap_vendor_service(uint8_t (*request_pending)(void));
+extern uint16_t dap_vendor_notify_get(uint8_t *buf, uint16_t size);
+extern uint16_t dap_vendor_rtt_read(uint8_t *buf, uint16_t size);
+extern uint16_t dap_vendor_rtt_write(const uint8_t *buf, uint16_t len);
+extern uint8_t dap_vendor_rtt_active(void);
+extern uint16_t dap_vendor_bscan_read(uint8_t *buf, uint16_t size);
+extern void dap_vendor_topology_reset(void);
 
 #ifdef __cplusplus
 }
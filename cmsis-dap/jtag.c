@@ -6,6 +6,15 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-12     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       stream IR/DR scans longer than 64 bits.
+ * 2026-10-18     SecondHandCoder       precompute DR scan templates per chain device.
+ * 2026-10-18     SecondHandCoder       add DR read trains for transfer block.
+ * 2026-10-18     SecondHandCoder       clock slow JTAG by the waveform engine.
+ * 2026-10-18     SecondHandCoder       add scan chain detection.
+ * 2026-10-18     SecondHandCoder       add generic DR scan for RISC-V DTM.
+ * 2026-10-18     SecondHandCoder       add long DR scans by SPI for boundary scan.
+ * 2026-10-18     SecondHandCoder       shift constant TMS sequences by SPI and DMA.
+ * 2026-10-18     SecondHandCoder       add TAP state moves for the SVF player.
  */
 
 #include "jtag.h"
@@ -27,10 +36,80 @@ typedef struct
     void (*jtag_rw)(uint32_t bits, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
     void (*jtag_rw_dr)(uint32_t dma_bytes, uint32_t bits_tail, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
     void (*jtag_delay)(void);
+    uint8_t wave;                       /* JTAG clocked by the waveform engine, SPI is not used */
 } jtag_control_t;
 
 static jtag_control_t jtag_control;
 
+/* Max bits of a scan built in the 64-bit buffers */
+#define JTAG_SCAN_BUF_BITS          64U
+
+/* JTAG DR scan template, request and data bits are ORed in per access */
+typedef struct
+{
+    uint64_t tms;                       /* TMS bits of the scan */
+    uint64_t tdi;                       /* TDI bits without request and data */
+    uint8_t dma_bytes;                  /* Bytes shifted by SPI */
+    uint8_t bits_tail;                  /* Bits bit-banged after SPI */
+    uint8_t valid;                      /* Scan fits the 64-bit buffers */
+} jtag_dr_tpl_t;
+
+/* DR scan templates of the devices on the chain, device index equals dr_before */
+typedef struct
+{
+    uint8_t count;                      /* JTAG number of devices */
+    jtag_dr_tpl_t dev[DAP_JTAG_DEV_CNT];
+} jtag_dr_chain_t;
+
+static jtag_dr_chain_t jtag_dr_chain;
+
+/* Max DR scans of a read train */
+#define JTAG_DR_TRAIN_CNT           16U
+/* Bytes of a read train buffer, 8 bytes of slack for the bit packing */
+#define JTAG_DR_TRAIN_SIZE          (((JTAG_DR_TRAIN_CNT * JTAG_SCAN_BUF_BITS) >> 3) + 8U)
+
+/* JTAG DR read train buffers */
+typedef struct
+{
+    uint8_t tms[JTAG_DR_TRAIN_SIZE];    /* TMS bits of the train */
+    uint8_t tdi[JTAG_DR_TRAIN_SIZE];    /* TDI bits of the train */
+    uint8_t tdo[JTAG_DR_TRAIN_SIZE];    /* TDO bits of the train */
+} jtag_dr_train_t;
+
+static jtag_dr_train_t jtag_dr_train;
+
+/* Max bits of the IR chain measured by the chain detection */
+#define JTAG_DETECT_IR_BITS         (DAP_JTAG_DEV_CNT * 32U)
+
+/* IR bits captured by the chain detection, one word more for the flush marker */
+static uint8_t jtag_detect_ir[(JTAG_DETECT_IR_BITS + 32U) >> 3];
+
+/* TAP next state, indexed by state and TMS */
+static const uint8_t jtag_tap_next[JTAG_TAP_STATES][2] = {
+    {JTAG_TAP_IDLE,         JTAG_TAP_RESET},        /* Test-Logic-Reset */
+    {JTAG_TAP_IDLE,         JTAG_TAP_DRSELECT},     /* Run-Test/Idle */
+    {JTAG_TAP_DRCAPTURE,    JTAG_TAP_IRSELECT},     /* Select-DR-Scan */
+    {JTAG_TAP_DRSHIFT,      JTAG_TAP_DREXIT1},      /* Capture-DR */
+    {JTAG_TAP_DRSHIFT,      JTAG_TAP_DREXIT1},      /* Shift-DR */
+    {JTAG_TAP_DRPAUSE,      JTAG_TAP_DRUPDATE},     /* Exit1-DR */
+    {JTAG_TAP_DRPAUSE,      JTAG_TAP_DREXIT2},      /* Pause-DR */
+    {JTAG_TAP_DRSHIFT,      JTAG_TAP_DRUPDATE},     /* Exit2-DR */
+    {JTAG_TAP_IDLE,         JTAG_TAP_DRSELECT},     /* Update-DR */
+    {JTAG_TAP_IRCAPTURE,    JTAG_TAP_RESET},        /* Select-IR-Scan */
+    {JTAG_TAP_IRSHIFT,      JTAG_TAP_IREXIT1},      /* Capture-IR */
+    {JTAG_TAP_IRSHIFT,      JTAG_TAP_IREXIT1},      /* Shift-IR */
+    {JTAG_TAP_IRPAUSE,      JTAG_TAP_IRUPDATE},     /* Exit1-IR */
+    {JTAG_TAP_IRPAUSE,      JTAG_TAP_IREXIT2},      /* Pause-IR */
+    {JTAG_TAP_IRSHIFT,      JTAG_TAP_IRUPDATE},     /* Exit2-IR */
+    {JTAG_TAP_IDLE,         JTAG_TAP_DRSELECT},     /* Update-IR */
+};
+
+/* Bytes of the TDI low and discarded TDO buffers of TAP clock runs */
+#define JTAG_TAP_CLOCK_BYTES        64U
+
+static uint8_t jtag_tap_clock_tdi[JTAG_TAP_CLOCK_BYTES];
+static uint8_t jtag_tap_clock_tdo[JTAG_TAP_CLOCK_BYTES];
+
 
 /**
  * @brief JTAG write/read quick, instruction scheduling.
@@ -438,6 +517,49 @@ static void jtag_rw_dr_slow(uint32_t bytelen_dma, uint32_t bitlen_tail, uint8_t
     }
 }
 
+#if (DAP_JTAG_WAVE != 0)
+/**
+ * @brief JTAG write/read by the waveform engine.
+ *
+ * @param bitlen            Len of instruction.
+ * @param tms               A pointer to the tms data buffer.
+ * @param tdi               A pointer to the tdi data buffer.
+ * @param tdo               A pointer to the tdo data buffer.
+ *
+ * @return None.
+ */
+static void jtag_rw_wave(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    uint32_t bits;
+
+    while (bitlen)
+    {
+        bits = (bitlen > 64U) ? 64U : bitlen;
+        dap_jtag_wave_rw(bits, tms, tdi, tdo);
+        tms += 8;
+        tdi += 8;
+        tdo += 8;
+        bitlen -= bits;
+    }
+}
+
+/**
+ * @brief JTAG write/read DR by the waveform engine, the whole scan is timed the same way.
+ *
+ * @param bytelen_dma       Len of instruction.
+ * @param bitlen_tail       Len of remain instruction.
+ * @param tms               A pointer to the tms data buffer.
+ * @param tdi               A pointer to the tdi data buffer.
+ * @param tdo               A pointer to the tdo data buffer.
+ *
+ * @return None.
+ */
+static void jtag_rw_dr_wave(uint32_t bytelen_dma, uint32_t bitlen_tail, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    jtag_rw_wave(8 + (bytelen_dma << 3) + bitlen_tail, tms, tdi, tdo);
+}
+#endif
+
 /**
  * @brief JTAG raw.
  *
@@ -453,6 +575,253 @@ void dap_jtag_raw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
     jtag_control.jtag_rw(bitlen, tms, tdi, tdo);
 }
 
+/**
+ * @brief JTAG shift up to 32 bits, LSB first.
+ *
+ * @param bitlen            Len of bits, 1 .. 32.
+ * @param tms               TMS bits.
+ * @param tdi               TDI bits.
+ *
+ * @return TDO bits.
+ */
+static uint32_t jtag_shift32(uint32_t bitlen, uint32_t tms, uint32_t tdi)
+{
+    uint32_t tdo = 0;
+
+    jtag_control.jtag_rw(bitlen, (uint8_t *)&tms, (uint8_t *)&tdi, (uint8_t *)&tdo);
+    return tdo;
+}
+
+/**
+ * @brief JTAG shift a run of any length with TMS low and constant TDI, bypass bits and idle.
+ *
+ * @param bitlen            Len of bits.
+ * @param tdi               TDI level, 0 or 0xFFFFFFFF.
+ *
+ * @return None.
+ */
+static void jtag_shift_run(uint32_t bitlen, uint32_t tdi)
+{
+    uint32_t bits;
+
+    while (bitlen)
+    {
+        bits = (bitlen > 32U) ? 32U : bitlen;
+        jtag_shift32(bits, 0, tdi);
+        bitlen -= bits;
+    }
+}
+
+/**
+ * @brief JTAG IR of any chain length, shifted in pieces.
+ *
+ * @param ir                IR value.
+ * @param lr_length         Len of IR value.
+ * @param ir_before         Bypass before data.
+ * @param ir_after          Bypass after data.
+ *
+ * @return None.
+ */
+static void jtag_ir_stream(uint32_t ir, uint32_t lr_length, uint32_t ir_before, uint32_t ir_after)
+{
+    // Select-DR-Scan, Select-IR-Scan, Capture-IR, Shift-IR
+    jtag_shift32(4, 0x3, 0);
+    // Bypass before data
+    jtag_shift_run(ir_before, 0xFFFFFFFFU);
+    if (ir_after)
+    {
+        jtag_shift32(lr_length, 0, ir);
+        // Bypass after data, Exit1-IR on the last bit
+        jtag_shift_run(ir_after - 1, 0xFFFFFFFFU);
+        jtag_shift32(1, 0x1, 0x1);
+    }
+    else
+    {
+        // Exit1-IR on the last IR bit
+        jtag_shift32(lr_length, 0x1U << (lr_length - 1), ir);
+    }
+    // Update-IR, idle, keep tdi high
+    jtag_shift32(2, 0x1, 0x2);
+}
+
+/**
+ * @brief JTAG DR of any chain length and idle count, shifted in pieces.
+ *
+ * @param request           Request value.
+ * @param dr                DR value.
+ * @param dr_before         Bypass before data.
+ * @param dr_after          Bypass after data.
+ * @param data              A pointer to the read data.
+ *
+ * @return Raw ack bits.
+ */
+static uint32_t jtag_dr_stream(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t dr_after, uint32_t *data)
+{
+    uint32_t ack;
+
+    if (request & DAP_TRANSFER_RnW)
+        dr = 0;
+
+    // Select-DR-Scan, Capture-DR, Shift-DR
+    jtag_shift32(3, 0x1, 0);
+    // Bypass before data
+    jtag_shift_run(dr_before, 0);
+    // RnW, A2, A3
+    ack = jtag_shift32(3, 0, (request >> 1) & 0x7);
+    // Data Transfer, Exit1-DR on the last bit
+    if (dr_after)
+    {
+        *data = jtag_shift32(32, 0, dr);
+        jtag_shift_run(dr_after - 1, 0);
+        jtag_shift32(1, 0x1, 0);
+    }
+    else
+    {
+        *data = jtag_shift32(32, 0x1U << 31, dr);
+    }
+    // Update-DR, Idle, keep tdi high
+    jtag_shift32(1, 0x1, 0);
+    jtag_shift_run(jtag_control.idle, 0);
+    jtag_shift32(1, 0, 0x1);
+    return ack;
+}
+
+/**
+ * @brief JTAG detect the scan chain from TAP reset. The device count is measured through
+ *        the BYPASS registers, the IR lengths are split at the IR capture 01 patterns and
+ *        the IDCODEs are read from DR after reset. The TAPs are left reset in Run-Test/Idle.
+ *
+ * @param max               Max num of devices.
+ * @param ir_length         A pointer to the IR length of each device.
+ * @param idcode            A pointer to the IDCODE of each device, 0 : BYPASS after reset.
+ * @param count             A pointer to the num of devices.
+ * @param ir_total          A pointer to the total IR bits of the chain.
+ *
+ * @return JTAG_DETECT_OK or the failed step.
+ */
+uint32_t dap_jtag_detect(uint32_t max, uint8_t *ir_length, uint32_t *idcode, uint32_t *count, uint32_t *ir_total)
+{
+    uint32_t n, pos, last, starts, tdo, ones = 0;
+
+    *count = 0;
+    *ir_total = 0;
+
+    // Test-Logic-Reset, Run-Test/Idle, IR holds IDCODE or BYPASS
+    jtag_shift32(6, 0x1F, 0x1);
+
+    // Select-DR-Scan, Select-IR-Scan, Capture-IR, Shift-IR
+    jtag_shift32(4, 0x3, 0xF);
+    // Capture IR bits while a 0 and then ones are shifted in, all IRs end up in BYPASS
+    for (pos = 0; pos < sizeof(jtag_detect_ir); pos += 4)
+    {
+        tdo = jtag_shift32(32, 0, pos ? 0xFFFFFFFFU : 0xFFFFFFFEU);
+        ones |= tdo;
+        jtag_detect_ir[pos] = (uint8_t)tdo;
+        jtag_detect_ir[pos + 1] = (uint8_t)(tdo >> 8);
+        jtag_detect_ir[pos + 2] = (uint8_t)(tdo >> 16);
+        jtag_detect_ir[pos + 3] = (uint8_t)(tdo >> 24);
+    }
+    // Exit1-IR, Update-IR, Idle
+    jtag_shift32(3, 0x3, 0x7);
+
+    // Ones are shifted in behind the 0, a chain that never returns one holds TDO low
+    if (!ones)
+        return JTAG_DETECT_TDO_LOW;
+
+    // The 0 shifted in is the last 0 out of TDO, its position is the IR chain length
+    last = sizeof(jtag_detect_ir) << 3;
+    for (pos = 0; pos < (sizeof(jtag_detect_ir) << 3); pos++)
+    {
+        if (!((jtag_detect_ir[pos >> 3] >> (pos & 0x7)) & 0x1))
+            last = pos;
+    }
+    if (last == (sizeof(jtag_detect_ir) << 3))
+        return JTAG_DETECT_TDO_HIGH;
+    if (!last)
+        return JTAG_DETECT_NO_CHAIN;
+    if (last >= JTAG_DETECT_IR_BITS)
+        return JTAG_DETECT_IR_TOO_LONG;
+    *ir_total = last;
+
+    // Select-DR-Scan, Capture-DR, Shift-DR, the BYPASS registers capture 0
+    jtag_shift32(3, 0x1, 0);
+    // Count the clocks until a 1 shifted in reaches TDO
+    for (n = 0; n <= max; n++)
+    {
+        if (jtag_shift32(1, 0, 0x1))
+            break;
+    }
+    // Exit1-DR, Update-DR, Idle
+    jtag_shift32(3, 0x3, 0x7);
+    if (!n)
+        return JTAG_DETECT_NO_CHAIN;
+    if (n > max)
+        return JTAG_DETECT_TOO_MANY;
+    *count = n;
+
+    // IDCODE starts with 1, a device in BYPASS shifts out a single 0
+    jtag_shift32(6, 0x1F, 0x1);
+    jtag_shift32(3, 0x1, 0x7);
+    for (n = 0; n < *count; n++)
+    {
+        if (jtag_shift32(1, 0, 0x1))
+            idcode[n] = 0x1 | (jtag_shift32(31, 0, 0x7FFFFFFFU) << 1);
+        else
+            idcode[n] = 0;
+    }
+    jtag_shift32(3, 0x3, 0x7);
+    jtag_shift32(6, 0x1F, 0x1);
+
+    if (*count == 1)
+    {
+        ir_length[0] = *ir_total;
+        return JTAG_DETECT_OK;
+    }
+
+    // A device starts where the captured IR bits read 1, 0
+    starts = 0;
+    last = 0;
+    for (pos = 0; (pos + 1) < *ir_total; pos++)
+    {
+        if (((jtag_detect_ir[pos >> 3] >> (pos & 0x7)) & 0x1) &&
+            !((jtag_detect_ir[(pos + 1) >> 3] >> ((pos + 1) & 0x7)) & 0x1))
+        {
+            if ((starts == *count) || (!starts && pos))
+                return JTAG_DETECT_IR_AMBIGUOUS;
+            if (starts)
+                ir_length[starts - 1] = pos - last;
+            last = pos;
+            starts++;
+        }
+    }
+    if (starts != *count)
+        return JTAG_DETECT_IR_AMBIGUOUS;
+    ir_length[starts - 1] = *ir_total - last;
+    return JTAG_DETECT_OK;
+}
+
+/**
+ * @brief JTAG read IDCODE, the IDCODE instruction must be loaded.
+ *
+ * @param dr_before         Bypass before data.
+ *
+ * @return IDCODE.
+ */
+uint32_t dap_jtag_read_idcode(uint32_t dr_before)
+{
+    uint32_t idcode;
+
+    // Select-DR-Scan, Capture-DR, Shift-DR
+    jtag_shift32(3, 0x1, 0);
+    // Bypass before data
+    jtag_shift_run(dr_before, 0);
+    // Data, Exit1-DR on the last bit
+    idcode = jtag_shift32(32, 0x1U << 31, 0);
+    // Update-DR, Idle
+    jtag_shift32(2, 0x1, 0);
+    return idcode;
+}
+
 /**
  * @brief JTAG IR.
  *
@@ -468,6 +837,12 @@ void dap_jtag_ir(uint32_t ir, uint32_t lr_length, uint32_t ir_before, uint32_t i
     uint32_t bitlen;
     uint64_t buf_tms, buf_tdi, buf_tdo;
 
+    if ((4U + ir_before + lr_length + ir_after + 2U) > JTAG_SCAN_BUF_BITS)
+    {
+        jtag_ir_stream(ir, lr_length, ir_before, ir_after);
+        return;
+    }
+
     buf_tdi = 0;
     lr_length--;
 
@@ -521,49 +896,121 @@ void dap_jtag_ir(uint32_t ir, uint32_t lr_length, uint32_t ir_before, uint32_t i
 }
 
 /**
- * @brief JTAG DR.
+ * @brief JTAG build the template of a DR scan.
  *
- * @param request           Request value.
- * @param dr                DR value.
+ * @param tpl               A pointer to the template.
  * @param dr_before         Bypass before data.
  * @param dr_after          Bypass after data.
  *
- * @return Result.
+ * @return None.
  */
-uint32_t dap_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t dr_after, uint8_t *data)
+static void jtag_dr_tpl_build(jtag_dr_tpl_t *tpl, uint32_t dr_before, uint32_t dr_after)
 {
-    uint32_t ack, retry, dma_bytes, bits_tail, bitlen;
-    uint64_t buf_tms, buf_tdi, buf_tdo;
+    uint32_t bitlen;
 
-    retry = 0;
-    buf_tdi = 0;
+    tpl->valid = (40U + dr_before + dr_after + jtag_control.idle) <= JTAG_SCAN_BUF_BITS;
+    if (!tpl->valid)
+        return;
 
     // Select-DR-Scan, Capture-DR, Shift-DR
-    buf_tms = 0x1;
+    tpl->tms = 0x1;
     bitlen = 3;
 
-    // Bypass before data
-    bitlen += dr_before;
-
-    // RnW, A2, A3
-    buf_tdi |= (uint64_t)((request >> 1) & 0x7) << bitlen;
-    bitlen += 3;
+    // Bypass before data, RnW, A2, A3
+    bitlen += dr_before + 3;
 
     // Data Transfer
-    if (!(request & DAP_TRANSFER_RnW))
-        buf_tdi |= (uint64_t)dr << bitlen;
     bitlen += 31 + dr_after;
-    dma_bytes = (bitlen - 8) >> 3;
-    buf_tms |= (uint64_t)0x1 << bitlen;
+    tpl->dma_bytes = (bitlen - 8) >> 3;
+    tpl->tms |= (uint64_t)0x1 << bitlen;
     bitlen++;
 
     // Update-DR, Idle
-    buf_tms |= (uint64_t)0x1 << bitlen;
+    tpl->tms |= (uint64_t)0x1 << bitlen;
     bitlen += 1 + jtag_control.idle;
-    buf_tdi |= (uint64_t)0x1 << bitlen;	// keep tdi high
+    tpl->tdi = (uint64_t)0x1 << bitlen;	// keep tdi high
     bitlen++;
 
-    bits_tail = bitlen - 8 - (dma_bytes << 3);
+    tpl->bits_tail = bitlen - 8 - (tpl->dma_bytes << 3);
+}
+
+/**
+ * @brief JTAG rebuild the DR templates of all devices on the chain.
+ *
+ * @return None.
+ */
+static void jtag_dr_chain_build(void)
+{
+    for (uint32_t n = 0; n < jtag_dr_chain.count; n++)
+        jtag_dr_tpl_build(&jtag_dr_chain.dev[n], n, jtag_dr_chain.count - n - 1);
+}
+
+/**
+ * @brief DAP JTAG set the number of devices on the chain and precompute their DR scans.
+ *
+ * @param count             JTAG number of devices.
+ *
+ * @return None.
+ */
+void dap_jtag_dr_chain(uint32_t count)
+{
+    jtag_dr_chain.count = (count > DAP_JTAG_DEV_CNT) ? DAP_JTAG_DEV_CNT : count;
+    jtag_dr_chain_build();
+}
+
+/**
+ * @brief JTAG DR.
+ *
+ * @param request           Request value.
+ * @param dr                DR value.
+ * @param dr_before         Bypass before data.
+ * @param dr_after          Bypass after data.
+ *
+ * @return Result.
+ */
+uint32_t dap_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t dr_after, uint8_t *data)
+{
+    uint32_t ack, retry, rdata;
+    uint64_t buf_tms, buf_tdi, buf_tdo;
+    jtag_dr_tpl_t *tpl, tpl_tmp;
+
+    retry = 0;
+
+    if ((dr_before < jtag_dr_chain.count) && ((dr_before + dr_after + 1U) == jtag_dr_chain.count))
+    {
+        tpl = &jtag_dr_chain.dev[dr_before];
+    }
+    else
+    {
+        tpl = &tpl_tmp;
+        jtag_dr_tpl_build(tpl, dr_before, dr_after);
+    }
+
+    if (!tpl->valid)
+    {
+    #if TIMESTAMP_CLOCK
+        if (request & DAP_TRANSFER_TIMESTAMP)
+            jtag_control.dap_timestamp = dap_get_cur_tick();
+    #endif
+        do
+        {
+            ack = jtag_dr_stream(request, dr, dr_before, dr_after, &rdata);
+            ack = (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
+            if (ack != DAP_TRANSFER_WAIT)
+                break;
+        } while (retry++ < jtag_control.retry_limit);
+
+        if (data)
+            __UNALIGNED_UINT32_WRITE(data, rdata);
+        return ack;
+    }
+
+    buf_tms = tpl->tms;
+    // RnW, A2, A3
+    buf_tdi = tpl->tdi | ((uint64_t)((request >> 1) & 0x7) << (dr_before + 3));
+    // Data Transfer
+    if (!(request & DAP_TRANSFER_RnW))
+        buf_tdi |= (uint64_t)dr << (dr_before + 6);
 
 #if TIMESTAMP_CLOCK
     if (request & DAP_TRANSFER_TIMESTAMP)
@@ -572,7 +1019,7 @@ uint32_t dap_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t
 
     do
     {
-        jtag_control.jtag_rw_dr(dma_bytes, bits_tail, (uint8_t *)&buf_tms, (uint8_t *)&buf_tdi, (uint8_t *)&buf_tdo);
+        jtag_control.jtag_rw_dr(tpl->dma_bytes, tpl->bits_tail, (uint8_t *)&buf_tms, (uint8_t *)&buf_tdi, (uint8_t *)&buf_tdo);
         ack = (buf_tdo >> (dr_before + 3)) & 0x7;
         ack = (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
         if (ack != DAP_TRANSFER_WAIT)
@@ -584,6 +1031,408 @@ uint32_t dap_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t
     return ack;
 }
 
+/**
+ * @brief JTAG shift whole bytes by SPI with TMS kept constant, long runs are moved by DMA.
+ *
+ * @param bytes             Num of bytes.
+ * @param tms               TMS level, 0 or 1.
+ * @param tdi               A pointer to the tdi data buffer.
+ * @param tdo               A pointer to the tdo data buffer.
+ *
+ * @return None.
+ */
+static void jtag_spi_bytes(uint32_t bytes, uint32_t tms, const uint8_t *tdi, uint8_t *tdo)
+{
+    if (tms)
+        DAP_JTAG_TMS_TO_HIGH();
+    else
+        DAP_JTAG_TMS_TO_LOW();
+    DAP_JTAG_TCK_TO_APP();
+    DAP_JTAG_TDI_TO_APP();
+#if (DAP_JTAG_SPI_DMA != 0)
+    if (bytes >= JTAG_SPI_DMA_MIN_BYTES)
+    {
+        dap_jtag_spi_dma(bytes, tdi, tdo);
+        bytes = 0;
+    }
+#endif
+    while (bytes--)
+    {
+        JTAG_WRITE_DATA(*tdi);
+        tdi++;
+        while (JTAG_WAIT_BUSY());
+        *tdo = JTAG_READ_DATA();
+        tdo++;
+    }
+    DAP_JTAG_TCK_TO_OPP();
+    DAP_JTAG_TDI_TO_OPP();
+}
+
+/**
+ * @brief JTAG write/read a bit stream, bytes with TMS low are shifted by SPI and the others bit-banged.
+ *
+ * @param bitlen            Len of instruction.
+ * @param tms               A pointer to the tms data buffer.
+ * @param tdi               A pointer to the tdi data buffer.
+ * @param tdo               A pointer to the tdo data buffer.
+ *
+ * @return None.
+ */
+static void jtag_rw_train(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo)
+{
+    uint32_t bytes = bitlen >> 3;
+    uint32_t run;
+
+    if (jtag_control.wave)
+    {
+        jtag_control.jtag_rw(bitlen, tms, tdi, tdo);
+        return;
+    }
+
+    while (bytes)
+    {
+        if (*tms)
+        {
+            jtag_control.jtag_rw(8, tms++, tdi++, tdo++);
+            bytes--;
+            continue;
+        }
+
+        for (run = 1; (run < bytes) && (tms[run] == 0); run++);
+        jtag_spi_bytes(run, 0, tdi, tdo);
+        tms += run;
+        tdi += run;
+        tdo += run;
+        bytes -= run;
+    }
+
+    if (bitlen & 0x7)
+        jtag_control.jtag_rw(bitlen & 0x7, tms, tdi, tdo);
+}
+
+/**
+ * @brief JTAG sequence with constant TMS, whole bytes go through SPI and only
+ *        the last bits are bit-banged.
+ *
+ * @param bitlen            Len of sequence.
+ * @param tms               TMS level, 0 or 1.
+ * @param tdi               A pointer to the tdi data, (bitlen + 7) / 8 bytes.
+ * @param tdo               A pointer to the tdo data, (bitlen + 7) / 8 bytes.
+ *
+ * @return None.
+ */
+void dap_jtag_seq(uint32_t bitlen, uint32_t tms, uint8_t *tdi, uint8_t *tdo)
+{
+    uint64_t tms_bits = tms ? ~0ULL : 0;
+    uint32_t bytes = bitlen >> 3;
+    uint32_t bits;
+
+    if (!jtag_control.wave && bytes)
+    {
+        jtag_spi_bytes(bytes, tms, tdi, tdo);
+        tdi += bytes;
+        tdo += bytes;
+        bitlen &= 0x7;
+    }
+
+    while (bitlen)
+    {
+        bits = (bitlen > 64U) ? 64U : bitlen;
+        jtag_control.jtag_rw(bits, (uint8_t *)&tms_bits, tdi, tdo);
+        tdi += 8;
+        tdo += 8;
+        bitlen -= bits;
+    }
+}
+
+/**
+ * @brief JTAG OR 64 bits into a byte buffer at a bit position, LSB first.
+ *
+ * @param buf               A pointer to the buffer, 9 bytes from the position are touched.
+ * @param pos               Bit position.
+ * @param val               Bits value.
+ *
+ * @return None.
+ */
+static void jtag_bits_put(uint8_t *buf, uint32_t pos, uint64_t val)
+{
+    uint32_t shift = pos & 0x7;
+
+    buf += pos >> 3;
+    for (uint32_t i = 0; i < 8; i++)
+        buf[i] |= (uint8_t)((val << shift) >> (i << 3));
+    if (shift)
+        buf[8] |= (uint8_t)(val >> (64 - shift));
+}
+
+/**
+ * @brief JTAG get 64 bits from a byte buffer at a bit position, LSB first.
+ *
+ * @param buf               A pointer to the buffer, 9 bytes from the position are read.
+ * @param pos               Bit position.
+ *
+ * @return Bits value.
+ */
+static uint64_t jtag_bits_get(const uint8_t *buf, uint32_t pos)
+{
+    uint32_t shift = pos & 0x7;
+    uint64_t val = 0;
+
+    buf += pos >> 3;
+    for (uint32_t i = 0; i < 8; i++)
+        val |= (uint64_t)buf[i] << (i << 3);
+    if (shift)
+        val = (val >> shift) | ((uint64_t)buf[8] << (64 - shift));
+    return val;
+}
+
+/**
+ * @brief JTAG DR read train, the same read request is shifted in back to back scans
+ *        without checking the ack between them. A scan with WAIT is ignored by the DP,
+ *        so only scans with OK count, each of them returns the data of the previous read.
+ *
+ * @param request           Request value, a read.
+ * @param dr_before         Bypass before data.
+ * @param dr_after          Bypass after data.
+ * @param cnt               Num of scans, JTAG_DR_TRAIN_CNT max.
+ * @param data              A pointer to the read data, no alignment needed.
+ * @param done              A pointer to the num of scans done with OK.
+ *
+ * @return Ack of the last scan parsed, 0 if the train can not be used for the chain.
+ */
+uint32_t dap_jtag_dr_train(uint32_t request, uint32_t dr_before, uint32_t dr_after, uint32_t cnt, uint8_t *data, uint32_t *done)
+{
+    jtag_dr_tpl_t *tpl, tpl_tmp;
+    uint32_t ack, bits, pos;
+    uint64_t tdi;
+
+    *done = 0;
+    if ((dr_before < jtag_dr_chain.count) && ((dr_before + dr_after + 1U) == jtag_dr_chain.count))
+    {
+        tpl = &jtag_dr_chain.dev[dr_before];
+    }
+    else
+    {
+        tpl = &tpl_tmp;
+        jtag_dr_tpl_build(tpl, dr_before, dr_after);
+    }
+    if (!tpl->valid || !cnt)
+        return 0;
+    if (cnt > JTAG_DR_TRAIN_CNT)
+        cnt = JTAG_DR_TRAIN_CNT;
+
+    bits = 40U + dr_before + dr_after + jtag_control.idle;
+    tdi = tpl->tdi | ((uint64_t)((request >> 1) & 0x7) << (dr_before + 3));
+
+    rt_memset(jtag_dr_train.tms, 0, sizeof(jtag_dr_train.tms));
+    rt_memset(jtag_dr_train.tdi, 0, sizeof(jtag_dr_train.tdi));
+    for (pos = 0; pos < bits * cnt; pos += bits)
+    {
+        jtag_bits_put(jtag_dr_train.tms, pos, tpl->tms);
+        jtag_bits_put(jtag_dr_train.tdi, pos, tdi);
+    }
+
+    jtag_rw_train(bits * cnt, jtag_dr_train.tms, jtag_dr_train.tdi, jtag_dr_train.tdo);
+
+    ack = DAP_TRANSFER_WAIT;
+    for (pos = 0; pos < bits * cnt; pos += bits)
+    {
+        uint64_t tdo = jtag_bits_get(jtag_dr_train.tdo, pos);
+
+        ack = (tdo >> (dr_before + 3)) & 0x7;
+        ack = (ack & 0x4) | ((ack & 0x2) >> 1) | ((ack & 0x1) << 1);
+        if (ack == DAP_TRANSFER_WAIT)
+            continue;
+        if (ack != DAP_TRANSFER_OK)
+            break;
+        __UNALIGNED_UINT32_WRITE(data, (uint32_t)(tdo >> (dr_before + 6)));
+        data += 4;
+        (*done)++;
+    }
+    return ack;
+}
+
+/**
+ * @brief JTAG generic DR scan up to 64 bits with its own idle count, used by non ARM TAPs.
+ *        The scan is built in the train buffers so the bytes with TMS low go through SPI.
+ *
+ * @param dr                DR value.
+ * @param dr_len            Len of DR value, 1 .. 64.
+ * @param dr_before         Bypass before data.
+ * @param dr_after          Bypass after data.
+ * @param idle              Run-Test/Idle cycles after the scan.
+ *
+ * @return Captured DR value.
+ */
+uint64_t dap_jtag_dr_scan(uint64_t dr, uint32_t dr_len, uint32_t dr_before, uint32_t dr_after, uint32_t idle)
+{
+    uint32_t bitlen, bytes;
+    uint64_t mask = (dr_len < 64U) ? (((uint64_t)0x1 << dr_len) - 1) : ~(uint64_t)0;
+
+    bitlen = 5U + dr_before + dr_len + dr_after + idle;
+    bytes = ((bitlen + 7U) >> 3) + 8U;
+    if (bytes > JTAG_DR_TRAIN_SIZE)
+        return 0;
+    rt_memset(jtag_dr_train.tms, 0, bytes);
+    rt_memset(jtag_dr_train.tdi, 0, bytes);
+
+    // Select-DR-Scan, Capture-DR, Shift-DR, bypass before data
+    jtag_dr_train.tms[0] = 0x1;
+    // Data, bypass after data, Exit1-DR on the last bit
+    jtag_bits_put(jtag_dr_train.tdi, 3U + dr_before, dr & mask);
+    bitlen = 3U + dr_before + dr_len + dr_after - 1U;
+    jtag_bits_put(jtag_dr_train.tms, bitlen, 0x3);
+    // Update-DR, Idle, keep tdi high
+    bitlen += 2U + idle;
+    jtag_bits_put(jtag_dr_train.tdi, bitlen, 0x1);
+    bitlen++;
+
+    jtag_rw_train(bitlen, jtag_dr_train.tms, jtag_dr_train.tdi, jtag_dr_train.tdo);
+    return jtag_bits_get(jtag_dr_train.tdo, 3U + dr_before) & mask;
+}
+
+/**
+ * @brief JTAG DR scan of a long register such as the boundary register, the data bytes
+ *        go through SPI and only the last bits are bit-banged.
+ *
+ * @param bitlen            Len of DR value, not 0.
+ * @param dr_before         Bypass before data.
+ * @param dr_after          Bypass after data.
+ * @param tdi               A pointer to the tdi data, (bitlen + 7) / 8 bytes.
+ * @param tdo               A pointer to the tdo data, (bitlen + 7) / 8 bytes.
+ *
+ * @return None.
+ */
+void dap_jtag_dr_bits(uint32_t bitlen, uint32_t dr_before, uint32_t dr_after, uint8_t *tdi, uint8_t *tdo)
+{
+    uint32_t bytes = (bitlen - 1U) >> 3;
+    uint32_t tail = bitlen - (bytes << 3);
+    uint64_t tms = 0;
+
+    // Select-DR-Scan, Capture-DR, Shift-DR
+    jtag_shift32(3, 0x1, 0);
+    // Bypass before data
+    jtag_shift_run(dr_before, 0);
+    // Data bytes, TMS is kept low
+    if (jtag_control.wave)
+    {
+        for (uint32_t n = 0; n < bytes; n += 8U)
+            jtag_control.jtag_rw(((bytes - n) > 8U) ? 64U : ((bytes - n) << 3), (uint8_t *)&tms, tdi + n, tdo + n);
+    }
+    else
+    {
+        jtag_spi_bytes(bytes, 0, tdi, tdo);
+    }
+    // Last data bits, Exit1-DR on the last bit if no bypass follows
+    if (!dr_after)
+        tms = 0x1U << (tail - 1U);
+    jtag_control.jtag_rw(tail, (uint8_t *)&tms, tdi + bytes, tdo + bytes);
+    // Bypass after data, Exit1-DR on the last bit
+    if (dr_after)
+    {
+        jtag_shift_run(dr_after - 1, 0);
+        jtag_shift32(1, 0x1, 0);
+    }
+    // Update-DR, Idle
+    jtag_shift32(2, 0x1, 0);
+}
+
+/**
+ * @brief JTAG move the TAP by the shortest TMS path, Test-Logic-Reset is always
+ *        entered by 5 TMS high so it also works from an unknown state.
+ *
+ * @param from              Current TAP state, JTAG_TAP_UNKNOWN if not known.
+ * @param to                Target TAP state.
+ *
+ * @return TAP state reached.
+ */
+uint32_t dap_jtag_tap_move(uint32_t from, uint32_t to)
+{
+    uint8_t queue[JTAG_TAP_STATES];
+    uint8_t len[JTAG_TAP_STATES];
+    uint8_t path[JTAG_TAP_STATES];
+    uint32_t head = 0, tail = 0;
+    uint32_t state, next, tms;
+
+    if ((to == JTAG_TAP_RESET) || (from >= JTAG_TAP_STATES))
+    {
+        jtag_shift32(5, 0x1F, 0);
+        from = JTAG_TAP_RESET;
+    }
+
+    rt_memset(len, 0xFF, sizeof(len));
+    len[from] = 0;
+    path[from] = 0;
+    queue[tail++] = from;
+    while (head < tail)
+    {
+        state = queue[head++];
+        if (state == to)
+        {
+            if (len[state])
+                jtag_shift32(len[state], path[state], 0);
+            break;
+        }
+        for (tms = 0; tms < 2U; tms++)
+        {
+            next = jtag_tap_next[state][tms];
+            if (len[next] != 0xFF)
+                continue;
+            len[next] = len[state] + 1U;
+            path[next] = path[state] | (tms << len[state]);
+            queue[tail++] = next;
+        }
+    }
+    return to;
+}
+
+/**
+ * @brief JTAG clock the TAP with constant TMS and TDI low, for Run-Test/Idle waits.
+ *
+ * @param cnt               Num of TCK.
+ * @param tms               TMS level, 0 or 1.
+ *
+ * @return None.
+ */
+void dap_jtag_tap_clock(uint32_t cnt, uint32_t tms)
+{
+    uint32_t bits;
+
+    while (cnt)
+    {
+        bits = (cnt > (JTAG_TAP_CLOCK_BYTES << 3)) ? (JTAG_TAP_CLOCK_BYTES << 3) : cnt;
+        dap_jtag_seq(bits, tms, jtag_tap_clock_tdi, jtag_tap_clock_tdo);
+        cnt -= bits;
+    }
+}
+
+/**
+ * @brief JTAG shift bits in Shift-IR/DR, the TAP is left on the last bit on request.
+ *
+ * @param bitlen            Len of bits, not 0.
+ * @param exit              1 : the last bit moves to Exit1-IR/DR, 0 : stay in Shift-IR/DR.
+ * @param tdi               A pointer to the tdi data, (bitlen + 7) / 8 bytes.
+ * @param tdo               A pointer to the tdo data, (bitlen + 7) / 8 bytes.
+ *
+ * @return None.
+ */
+void dap_jtag_tap_shift(uint32_t bitlen, uint32_t exit, uint8_t *tdi, uint8_t *tdo)
+{
+    uint32_t last = bitlen - 1U;
+
+    if (!exit)
+    {
+        dap_jtag_seq(bitlen, 0, tdi, tdo);
+        return;
+    }
+
+    dap_jtag_seq(last, 0, tdi, tdo);
+    if (jtag_shift32(1, 0x1, tdi[last >> 3] >> (last & 0x7)) & 0x1)
+        tdo[last >> 3] |= 1U << (last & 0x7);
+    else
+        tdo[last >> 3] &= ~(1U << (last & 0x7));
+}
+
 /**
  * @brief DAP JTAG init, GPIO parameter set.
  *
@@ -596,6 +1445,7 @@ void dap_jtag_init(void)
     dap_jtag_trans_init();
 
     rt_memset(&jtag_control, 0, sizeof(jtag_control_t));
+    jtag_dr_chain_build();
 }
 
 /**
@@ -631,6 +1481,16 @@ void dap_jtag_config(uint16_t kHz, uint16_t retry, uint8_t idle)
         jtag_control.jtag_rw = jtag_rw_slow;
         jtag_control.jtag_rw_dr = jtag_rw_dr_slow;
     }    
+
+#if (DAP_JTAG_WAVE != 0)
+    jtag_control.wave = dap_jtag_wave_init(kHz);
+    if (jtag_control.wave)
+    {
+        jtag_control.jtag_rw = jtag_rw_wave;
+        jtag_control.jtag_rw_dr = jtag_rw_dr_wave;
+    }
+#endif
+    jtag_dr_chain_build();
 }
 
 #if TIMESTAMP_CLOCK
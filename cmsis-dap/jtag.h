@@ -8,10 +8,40 @@
 extern "C" {
 #endif
 
+// TAP states, numbered as in XSVF
+#define JTAG_TAP_RESET              0x00U
+#define JTAG_TAP_IDLE               0x01U
+#define JTAG_TAP_DRSELECT           0x02U
+#define JTAG_TAP_DRCAPTURE          0x03U
+#define JTAG_TAP_DRSHIFT            0x04U
+#define JTAG_TAP_DREXIT1            0x05U
+#define JTAG_TAP_DRPAUSE            0x06U
+#define JTAG_TAP_DREXIT2            0x07U
+#define JTAG_TAP_DRUPDATE           0x08U
+#define JTAG_TAP_IRSELECT           0x09U
+#define JTAG_TAP_IRCAPTURE          0x0AU
+#define JTAG_TAP_IRSHIFT            0x0BU
+#define JTAG_TAP_IREXIT1            0x0CU
+#define JTAG_TAP_IRPAUSE            0x0DU
+#define JTAG_TAP_IREXIT2            0x0EU
+#define JTAG_TAP_IRUPDATE           0x0FU
+#define JTAG_TAP_STATES             16U
+#define JTAG_TAP_UNKNOWN            0xFFU
+
 #if (DAP_JTAG != 0)
 extern void dap_jtag_raw(uint32_t bitlen, uint8_t *tms, uint8_t *tdi, uint8_t *tdo);
 extern void dap_jtag_ir(uint32_t ir, uint32_t lr_length, uint32_t ir_before, uint32_t ir_after);
 extern uint32_t dap_jtag_dr(uint32_t request, uint32_t dr, uint32_t dr_before, uint32_t dr_after, uint8_t *data);
+extern uint32_t dap_jtag_read_idcode(uint32_t dr_before);
+extern void dap_jtag_dr_chain(uint32_t count);
+extern uint32_t dap_jtag_detect(uint32_t max, uint8_t *ir_length, uint32_t *idcode, uint32_t *count, uint32_t *ir_total);
+extern uint32_t dap_jtag_dr_train(uint32_t request, uint32_t dr_before, uint32_t dr_after, uint32_t cnt, uint8_t *data, uint32_t *done);
+extern uint64_t dap_jtag_dr_scan(uint64_t dr, uint32_t dr_len, uint32_t dr_before, uint32_t dr_after, uint32_t idle);
+extern void dap_jtag_seq(uint32_t bitlen, uint32_t tms, uint8_t *tdi, uint8_t *tdo);
+extern void dap_jtag_dr_bits(uint32_t bitlen, uint32_t dr_before, uint32_t dr_after, uint8_t *tdi, uint8_t *tdo);
+extern uint32_t dap_jtag_tap_move(uint32_t from, uint32_t to);
+extern void dap_jtag_tap_clock(uint32_t cnt, uint32_t tms);
+extern void dap_jtag_tap_shift(uint32_t bitlen, uint32_t exit, uint8_t *tdi, uint8_t *tdo);
 extern void dap_jtag_init(void);
 extern void dap_jtag_deinit(void);
 extern void dap_jtag_config(uint16_t kHz, uint16_t retry, uint8_t idle);
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author                Notes
  * 2023-11-12     SecondHandCoder       first version.
+ * 2026-10-18     SecondHandCoder       add multi-drop target select.
  */
 
 #include "swd.h"
@@ -999,6 +1000,36 @@ uint32_t dap_swd_write(uint32_t request, uint8_t *w_data)
     return swd_control.swd_write(request, w_data);
 }
 
+/**
+ * @brief SWD multi-drop target select, line reset, TARGETSEL write and DPIDR read.
+ *        TARGETSEL has no ACK, the ACK phase is clocked with the line released.
+ *
+ * @param targetsel         TARGETSEL value.
+ * @param dpidr             A pointer to the DPIDR read buffer.
+ *
+ * @return Result of the DPIDR read.
+ */
+uint32_t dap_swd_targetsel(uint32_t targetsel, uint8_t *dpidr)
+{
+    /* line reset 56 ones, idle 8 zeros */
+    uint8_t reset[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00};
+    /* start, DP, write, A[3:2] = 11, parity, stop, park */
+    uint8_t request = 0x99;
+    uint8_t data[5], ack[4];
+
+    __UNALIGNED_UINT32_WRITE(data, targetsel);
+    data[4] = (uint8_t)get_parity_32bit(targetsel);
+
+    dap_swd_seqout(reset, 64);
+    dap_swd_seqout(&request, 8);
+    // Trn:[C]*trn --> ACK:[C]*3 --> Trn:[C]*trn
+    dap_swd_seqin(ack, swd_control.trn * 2U + 3U);
+    dap_swd_seqout(data, 33);
+    dap_swd_seqout(&reset[7], 8);
+
+    return swd_control.swd_read(DP_IDCODE | DAP_TRANSFER_RnW, dpidr);
+}
+
 /**
  * @brief DAP SWD init, GPIO parameter set.
  *
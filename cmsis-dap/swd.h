@@ -12,6 +12,7 @@ extern "C" {
 #if (DAP_SWD != 0)
 extern uint32_t dap_swd_read(uint32_t request, uint8_t *r_data);
 extern uint32_t dap_swd_write(uint32_t request, uint8_t *w_data);
+extern uint32_t dap_swd_targetsel(uint32_t targetsel, uint8_t *dpidr);
 extern void dap_swd_seqout(uint8_t *data, uint32_t bitlen);
 extern void dap_swd_seqin(uint8_t *data, uint32_t bitlen);
 extern void dap_swd_init(void);
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "boot_lz.h"
+
+// Same as the bootloader, the image is padded to whole pages
+#define PAGE_SIZE               256U
+// Compressed data carried by one bootloader package
+#define PACKAGE_DATA_SIZE       (512U - 8U)
+
+// Decode the stream the way the bootloader does, package by package into page buffers
+int verify(const uint8_t *raw, uint32_t raw_len, const uint8_t *lz, uint32_t lz_len)
+{
+    static lz_decoder_t dec;
+    uint8_t page[PAGE_SIZE];
+    uint32_t page_point = 0, raw_point = 0, lz_point = 0;
+
+    lz_decoder_init(&dec);
+    while (lz_point < lz_len)
+    {
+        uint32_t package = lz_len - lz_point;
+        uint32_t consumed = 0;
+
+        if (package > PACKAGE_DATA_SIZE)
+            package = PACKAGE_DATA_SIZE;
+
+        while (consumed < package)
+        {
+            uint32_t in_len = package - consumed;
+
+            page_point += lz_decode(&dec, lz + lz_point + consumed, &in_len, page + page_point, PAGE_SIZE - page_point);
+            consumed += in_len;
+            if (page_point == PAGE_SIZE)
+            {
+                if ((raw_point + PAGE_SIZE > raw_len) || memcmp(page, raw + raw_point, PAGE_SIZE))
+                    return -1;
+                raw_point += PAGE_SIZE;
+                page_point = 0;
+            }
+        }
+        lz_point += package;
+    }
+
+    return ((raw_point == raw_len) && (page_point == 0)) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *src, *dest;
+    uint8_t *raw, *lz;
+    long size;
+    uint32_t raw_len, lz_len;
+
+    if (argc != 3)
+    {
+        printf("Usage: %s <input file name> <output file name>\n", argv[0]);
+        return -1;
+    }
+
+    src = fopen(argv[1], "rb");
+    if (!src)
+    {
+        perror("Error: Source file does not exist");
+        return -1;
+    }
+    fseek(src, 0, SEEK_END);
+    size = ftell(src);
+    fseek(src, 0, SEEK_SET);
+
+    // Pad the image to whole pages with the erased value
+    raw_len = ((uint32_t)size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    raw = malloc(raw_len ? raw_len : 1);
+    lz = malloc(LZ_ENCODE_BOUND(raw_len) + 1);
+    if (!raw || !lz)
+    {
+        printf("Error: Out of memory\n");
+        fclose(src);
+        return -1;
+    }
+    memset(raw, 0xFF, raw_len);
+    if (fread(raw, 1, size, src) != (size_t)size)
+    {
+        perror("Error: Failed to read source file");
+        fclose(src);
+        return -1;
+    }
+    fclose(src);
+
+    lz_len = lz_encode(raw, raw_len, lz, LZ_ENCODE_BOUND(raw_len) + 1);
+    if ((raw_len && !lz_len) || verify(raw, raw_len, lz, lz_len))
+    {
+        printf("Error: Compressed data does not decode to the source file\n");
+        return -1;
+    }
+
+    dest = fopen(argv[2], "wb");
+    if (!dest)
+    {
+        perror("Error: Failed to create destination file");
+        return -1;
+    }
+    fwrite(lz, 1, lz_len, dest);
+    fclose(dest);
+
+    printf("%u pages, %u bytes -> %u bytes (%u%%)\n", raw_len / PAGE_SIZE, raw_len, lz_len,
+           raw_len ? (unsigned)((uint64_t)lz_len * 100 / raw_len) : 0);
+    free(raw);
+    free(lz);
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "boot_lz.h"
+
+// Largest test image
+#define TEST_SIZE_MAX           (64U * 1024U)
+// Decoded data past the image shows an overrun
+#define TEST_SLACK              (2U * LZ_MAX_MATCH)
+
+/* input and output chunk sizes the decoder is fed with */
+typedef struct
+{
+    uint32_t in_step;
+    uint32_t out_step;
+} test_step_t;
+
+static const test_step_t test_step[] =
+{
+    {0xFFFFFFFFU, 0xFFFFFFFFU},                 // whole stream at once
+    {1U, 1U},                                   // every state split across calls
+    {512U - 8U, 256U},                          // bootloader package into page buffers
+    {7U, 13U},                                  // odd splits
+};
+
+static uint8_t raw[TEST_SIZE_MAX];
+static uint8_t lz[LZ_ENCODE_BOUND(TEST_SIZE_MAX) + 1];
+static uint8_t out[TEST_SIZE_MAX + TEST_SLACK];
+static uint32_t seed = 1;
+
+static uint8_t test_rand(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return (uint8_t)(seed >> 16);
+}
+
+// Decode in chunks, returns the decoded len, 0xFFFFFFFF if the input is not used up
+static uint32_t decode(const uint8_t *src, uint32_t src_len, uint8_t *dest, uint32_t dest_size, const test_step_t *step)
+{
+    static lz_decoder_t dec;
+    uint32_t src_point = 0, dest_point = 0;
+
+    lz_decoder_init(&dec);
+    while (1)
+    {
+        uint32_t in_len = src_len - src_point;
+        uint32_t out_len = dest_size - dest_point;
+        uint32_t n;
+
+        if (in_len > step->in_step)
+            in_len = step->in_step;
+        if (out_len > step->out_step)
+            out_len = step->out_step;
+        n = lz_decode(&dec, src + src_point, &in_len, dest + dest_point, out_len);
+        src_point += in_len;
+        dest_point += n;
+        if (!n && !in_len)
+            break;
+    }
+
+    return (src_point == src_len) ? dest_point : 0xFFFFFFFFU;
+}
+
+// Walk the items of a stream, longest match and farthest distance used
+static void scan(const uint8_t *src, uint32_t src_len, uint32_t *max_len, uint32_t *max_dist)
+{
+    uint32_t point = 0, len, dist;
+    uint8_t flags = 0, flag_bits = 0;
+
+    *max_len = 0;
+    *max_dist = 0;
+    while (point < src_len)
+    {
+        if (flag_bits == 0)
+        {
+            flags = src[point++];
+            flag_bits = 8;
+            continue;
+        }
+        if (flags & 0x01)
+        {
+            point++;
+        }
+        else if ((point + 2) <= src_len)
+        {
+            dist = (((uint32_t)(src[point + 1] >> 6) << 8) | src[point]) + 1;
+            len = (src[point + 1] & 0x3F) + LZ_MIN_MATCH;
+            if (len > *max_len)
+                *max_len = len;
+            if (dist > *max_dist)
+                *max_dist = dist;
+            point += 2;
+        }
+        else
+        {
+            break;
+        }
+        flags >>= 1;
+        flag_bits--;
+    }
+}
+
+// Round trip one image, the stream must also reach the expected match length and distance
+static int test(const char *name, uint32_t len, uint32_t need_len, uint32_t need_dist)
+{
+    uint32_t lz_len, max_len, max_dist, dec_len;
+
+    lz_len = lz_encode(raw, len, lz, sizeof(lz));
+    if (len && !lz_len)
+    {
+        printf("%-14s FAIL encode\n", name);
+        return -1;
+    }
+    for (uint32_t i = 0; i < sizeof(test_step) / sizeof(test_step[0]); i++)
+    {
+        memset(out, 0xA5, sizeof(out));
+        dec_len = decode(lz, lz_len, out, len + TEST_SLACK, &test_step[i]);
+        if ((dec_len != len) || memcmp(out, raw, len))
+        {
+            printf("%-14s FAIL decode, in step %u, out step %u\n", name, test_step[i].in_step, test_step[i].out_step);
+            return -1;
+        }
+    }
+    scan(lz, lz_len, &max_len, &max_dist);
+    if ((max_len < need_len) || (max_dist < need_dist))
+    {
+        printf("%-14s FAIL coverage, match len %u, dist %u\n", name, max_len, max_dist);
+        return -1;
+    }
+
+    printf("%-14s ok %6u -> %6u bytes, match len %2u, dist %4u\n", name, len, lz_len, max_len, max_dist);
+    return 0;
+}
+
+int main(void)
+{
+    uint32_t len, i, run;
+    int err = 0;
+
+    err |= test("empty", 0, 0, 0);
+
+    // Erased flash, matches of the max length overlapping at distance 1
+    memset(raw, 0xFF, 4096);
+    err |= test("erased", 4096, LZ_MAX_MATCH, 0);
+
+    // Nothing repeats, literals only
+    for (i = 0; i < 4096; i++)
+        raw[i] = test_rand();
+    err |= test("random", 4096, 0, 0);
+
+    // A block repeated at exactly the window size, the farthest match
+    for (i = 0; i < LZ_WINDOW_SIZE; i++)
+        raw[i] = test_rand();
+    for (i = LZ_WINDOW_SIZE; i < 4 * LZ_WINDOW_SIZE; i++)
+        raw[i] = raw[i - LZ_WINDOW_SIZE];
+    err |= test("window", 4 * LZ_WINDOW_SIZE, LZ_MAX_MATCH, LZ_WINDOW_SIZE);
+
+    // A block repeated just past the window, out of reach
+    for (i = 0; i <= LZ_WINDOW_SIZE; i++)
+        raw[i] = test_rand();
+    for (i = LZ_WINDOW_SIZE + 1; i < 4 * LZ_WINDOW_SIZE; i++)
+        raw[i] = raw[i - LZ_WINDOW_SIZE - 1];
+    err |= test("past window", 4 * LZ_WINDOW_SIZE, 0, 0);
+
+    // Runs around the min and max match length
+    len = 0;
+    for (run = 1; run <= LZ_MAX_MATCH + 2; run++)
+    {
+        uint8_t byte = test_rand();
+
+        for (i = 0; i < run; i++)
+            raw[len++] = byte;
+    }
+    err |= test("runs", len, LZ_MAX_MATCH, 0);
+
+    // Code like data over many windows, the decoder history wraps again and again
+    len = 0;
+    while (len < TEST_SIZE_MAX)
+    {
+        uint32_t dist = 1 + (test_rand() | ((uint32_t)test_rand() << 8)) % LZ_WINDOW_SIZE;
+
+        run = 1 + test_rand() % (2 * LZ_MAX_MATCH);
+        if ((len > dist) && (test_rand() & 0x03))
+        {
+            for (i = 0; (i < run) && (len < TEST_SIZE_MAX); i++, len++)
+                raw[len] = raw[len - dist];
+        }
+        else
+        {
+            for (i = 0; (i < run) && (len < TEST_SIZE_MAX); i++, len++)
+                raw[len] = test_rand();
+        }
+    }
+    err |= test("mixed", TEST_SIZE_MAX, LZ_MAX_MATCH, LZ_WINDOW_SIZE - 64U);
+
+    printf(err ? "FAILED\n" : "PASSED\n");
+    return err ? 1 : 0;
+}
@@ -0,0 +1,817 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+// Same as the probe, see the SVF player in cmsis-dap/dap_vendor.c
+#define SVF_OP_STATE            0x01U
+#define SVF_OP_SIR              0x02U
+#define SVF_OP_SDR              0x03U
+#define SVF_OP_RUNTEST          0x04U
+#define SVF_OP_TRST             0x05U
+#define SVF_SCAN_FIRST          0x01U
+#define SVF_SCAN_LAST           0x02U
+#define SVF_SCAN_COMPARE        0x04U
+#define SVF_SCAN_RETRY          0x08U
+#define SVF_CHUNK_BITS          1024U
+#define SVF_TRST_ON             0x00U
+#define SVF_TRST_OFF            0x01U
+#define SVF_TRST_Z              0x02U
+#define SVF_TRST_ABSENT         0x03U
+// Payload of one exec command: packet size, command ID, exec command, payload len
+#define SVF_PAYLOAD_MAX         (512U - 4U)
+// Largest operation: scan head, retry, TDI, TDO and mask of a chunk
+#define SVF_OP_MAX              (10U + (SVF_CHUNK_BITS / 8U) * 3U)
+
+// TAP states, numbered as in XSVF
+#define TAP_RESET               0x00U
+#define TAP_IDLE                0x01U
+#define TAP_DRPAUSE             0x06U
+#define TAP_IRPAUSE             0x0DU
+#define TAP_STATES              16U
+
+// Tokens of one SVF statement
+#define SVF_TOKENS_MAX          64
+
+// XSVF commands
+#define XCOMPLETE               0x00U
+#define XTDOMASK                0x01U
+#define XSIR                    0x02U
+#define XSDR                    0x03U
+#define XRUNTEST                0x04U
+#define XREPEAT                 0x07U
+#define XSDRSIZE                0x08U
+#define XSDRTDO                 0x09U
+#define XSETSDRMASKS            0x0AU
+#define XSDRINC                 0x0BU
+#define XSDRB                   0x0CU
+#define XSDRC                   0x0DU
+#define XSDRE                   0x0EU
+#define XSDRTDOB                0x0FU
+#define XSDRTDOC                0x10U
+#define XSDRTDOE                0x11U
+#define XSTATE                  0x12U
+#define XENDIR                  0x13U
+#define XENDDR                  0x14U
+#define XSIR2                   0x15U
+#define XCOMMENT                0x16U
+#define XWAIT                   0x17U
+
+// Scan parameters of a SVF SIR/SDR/HIR/HDR/TIR/TDR command, bits LSB first
+typedef struct
+{
+    uint32_t len;
+    int has_tdo;
+    uint8_t *tdi;
+    uint8_t *tdo;
+    uint8_t *mask;
+} scan_para_t;
+
+static const char *tap_names[TAP_STATES] = {
+    "RESET", "IDLE", "DRSELECT", "DRCAPTURE", "DRSHIFT", "DREXIT1", "DRPAUSE", "DREXIT2",
+    "DRUPDATE", "IRSELECT", "IRCAPTURE", "IRSHIFT", "IREXIT1", "IRPAUSE", "IREXIT2", "IRUPDATE",
+};
+
+static FILE *out_file;
+static FILE *map_file;
+static uint8_t frame[SVF_PAYLOAD_MAX];
+static uint32_t frame_len;
+static uint32_t frame_cnt;
+static uint32_t scan_cnt;
+static uint32_t op_cnt;
+
+// Write the pending payload as one frame: len (u16 little endian), payload
+static void frame_flush(void)
+{
+    uint8_t head[2];
+
+    if (!frame_len)
+        return;
+    head[0] = (uint8_t)frame_len;
+    head[1] = (uint8_t)(frame_len >> 8);
+    fwrite(head, 1, 2, out_file);
+    fwrite(frame, 1, frame_len, out_file);
+    frame_len = 0;
+    frame_cnt++;
+}
+
+// Operations never span two frames
+static void frame_put(const uint8_t *op, uint32_t len)
+{
+    if ((frame_len + len) > SVF_PAYLOAD_MAX)
+        frame_flush();
+    memcpy(frame + frame_len, op, len);
+    frame_len += len;
+    op_cnt++;
+}
+
+static void put_u16(uint8_t *p, uint32_t val)
+{
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t val)
+{
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+    p[2] = (uint8_t)(val >> 16);
+    p[3] = (uint8_t)(val >> 24);
+}
+
+static int bit_get(const uint8_t *buf, uint32_t pos)
+{
+    return (buf[pos >> 3] >> (pos & 0x7)) & 0x1;
+}
+
+static void bit_set(uint8_t *buf, uint32_t pos, int val)
+{
+    if (val)
+        buf[pos >> 3] |= (uint8_t)(1U << (pos & 0x7));
+    else
+        buf[pos >> 3] &= (uint8_t)~(1U << (pos & 0x7));
+}
+
+static void bits_copy(uint8_t *dst, uint32_t dst_pos, const uint8_t *src, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+        bit_set(dst, dst_pos + i, bit_get(src, i));
+}
+
+static void emit_state(uint32_t state)
+{
+    uint8_t op[2] = {SVF_OP_STATE, (uint8_t)state};
+
+    frame_put(op, sizeof(op));
+}
+
+static void emit_runtest(uint32_t run, uint32_t end, uint32_t tck, uint32_t us)
+{
+    uint8_t op[11];
+
+    op[0] = SVF_OP_RUNTEST;
+    op[1] = (uint8_t)run;
+    op[2] = (uint8_t)end;
+    put_u32(op + 3, tck);
+    put_u32(op + 7, us);
+    frame_put(op, sizeof(op));
+}
+
+static void emit_trst(uint32_t mode)
+{
+    uint8_t op[2] = {SVF_OP_TRST, (uint8_t)mode};
+
+    frame_put(op, sizeof(op));
+}
+
+/*
+ * Emit a scan in chunks of SVF_CHUNK_BITS, tdo is NULL if not compared. first/last
+ * tell if the scan enters and leaves Shift-IR/DR, XSVF begin/continue/end scans clear them.
+ * The XSVF repeat and wait go with a single chunk, a longer scan waits by a RUNTEST.
+ */
+static void emit_scan(int ir, uint32_t bits, const uint8_t *tdi, const uint8_t *tdo, const uint8_t *mask,
+                      int first, int last, uint32_t end, uint32_t repeat, uint32_t wait, uint32_t line)
+{
+    static uint8_t op[SVF_OP_MAX];
+    uint32_t pos, n, bytes, head, retry;
+
+    retry = (repeat || wait) && first && last && (bits <= SVF_CHUNK_BITS);
+    for (pos = 0; pos < bits; pos += n)
+    {
+        n = ((bits - pos) > SVF_CHUNK_BITS) ? SVF_CHUNK_BITS : (bits - pos);
+        bytes = (n + 7) >> 3;
+        op[0] = ir ? SVF_OP_SIR : SVF_OP_SDR;
+        op[1] = 0;
+        if (first && (pos == 0))
+            op[1] |= SVF_SCAN_FIRST;
+        if (last && ((pos + n) == bits))
+            op[1] |= SVF_SCAN_LAST;
+        if (tdo)
+            op[1] |= SVF_SCAN_COMPARE;
+        op[2] = (uint8_t)end;
+        put_u16(op + 3, n);
+        head = 5;
+        if (retry)
+        {
+            op[1] |= SVF_SCAN_RETRY;
+            op[head] = (uint8_t)((repeat > 255) ? 255 : repeat);
+            put_u32(op + head + 1, wait);
+            head += 5;
+        }
+        // Chunks start on a byte, the bits past the chunk are cleared
+        memset(op + head, 0, bytes * (tdo ? 3 : 1));
+        bits_copy(op + head, 0, tdi + (pos >> 3), n);
+        if (tdo)
+        {
+            bits_copy(op + head + bytes, 0, tdo + (pos >> 3), n);
+            bits_copy(op + head + bytes * 2, 0, mask + (pos >> 3), n);
+        }
+        frame_put(op, head + bytes * (tdo ? 3 : 1));
+    }
+
+    if (!last)
+        return;
+    if ((repeat || wait) && !retry)
+    {
+        if (repeat)
+            printf("Warning: line %u, %u bits scan is too long to be repeated on mismatch\n", line, bits);
+        if (wait)
+            emit_runtest(end, end, 0, wait);
+    }
+    if (map_file)
+        fprintf(map_file, "%u %u\n", scan_cnt, line);
+    scan_cnt++;
+}
+
+/* ---------------------------------------- SVF ---------------------------------------- */
+
+static scan_para_t para_hir, para_hdr, para_tir, para_tdr, para_sir, para_sdr;
+static uint32_t svf_endir = TAP_IDLE;
+static uint32_t svf_enddr = TAP_IDLE;
+static uint32_t svf_run_state = TAP_IDLE;
+static uint32_t svf_run_end = TAP_IDLE;
+static uint8_t *svf_buf[3];
+static uint32_t svf_buf_size;
+
+static int svf_state(const char *name)
+{
+    uint32_t i;
+
+    for (i = 0; i < TAP_STATES; i++)
+    {
+        if (!strcmp(name, tap_names[i]))
+            return (int)i;
+    }
+    return -1;
+}
+
+static void *xrealloc(void *p, size_t size)
+{
+    p = realloc(p, size ? size : 1);
+    if (!p)
+    {
+        printf("Error: Out of memory\n");
+        exit(-1);
+    }
+    return p;
+}
+
+// A new length drops TDI and MASK, they are only kept while the length is the same
+static void para_len(scan_para_t *para, uint32_t len)
+{
+    uint32_t bytes = (len + 7) >> 3;
+
+    if ((len == para->len) && para->tdi)
+        return;
+    para->len = len;
+    para->tdi = xrealloc(para->tdi, bytes);
+    para->tdo = xrealloc(para->tdo, bytes);
+    para->mask = xrealloc(para->mask, bytes);
+    memset(para->tdi, 0, bytes);
+    memset(para->tdo, 0, bytes);
+    memset(para->mask, 0xFF, bytes);
+}
+
+// Hex string, the last digit holds bit 0, digits beyond the length must be 0
+static int svf_hex(const char *hex, uint8_t *buf, uint32_t len)
+{
+    int32_t i = (int32_t)strlen(hex) - 1;
+    uint32_t pos, digit, b;
+
+    memset(buf, 0, (len + 7) >> 3);
+    for (pos = 0; i >= 0; i--, pos += 4)
+    {
+        if (!isxdigit((unsigned char)hex[i]))
+            return -1;
+        digit = isdigit((unsigned char)hex[i]) ? (uint32_t)(hex[i] - '0') : (uint32_t)(toupper((unsigned char)hex[i]) - 'A' + 10);
+        for (b = 0; b < 4; b++)
+        {
+            if ((digit >> b) & 0x1)
+            {
+                if ((pos + b) >= len)
+                    return -1;
+                bit_set(buf, pos + b, 1);
+            }
+        }
+    }
+    return 0;
+}
+
+// length [TDI (hex)] [TDO (hex)] [MASK (hex)] [SMASK (hex)], TDO is only kept for HIR/HDR/TIR/TDR
+static int svf_para(char **tok, int cnt, scan_para_t *para, int sticky_tdo)
+{
+    uint8_t *buf;
+    int i;
+
+    if (cnt < 2)
+        return -1;
+    para_len(para, (uint32_t)strtoul(tok[1], NULL, 10));
+    if (!sticky_tdo)
+        para->has_tdo = 0;
+    for (i = 2; (i + 1) < cnt; i += 2)
+    {
+        if (tok[i + 1][0] != '(')
+            return -1;
+        if (!strcmp(tok[i], "TDI"))
+            buf = para->tdi;
+        else if (!strcmp(tok[i], "TDO"))
+        {
+            buf = para->tdo;
+            para->has_tdo = 1;
+        }
+        else if (!strcmp(tok[i], "MASK"))
+            buf = para->mask;
+        else if (!strcmp(tok[i], "SMASK"))
+            continue;
+        else
+            return -1;
+        if (svf_hex(tok[i + 1] + 1, buf, para->len))
+            return -1;
+    }
+    if (i != cnt)
+        return -1;
+    return 0;
+}
+
+// Header, data and trailer are shifted in this order, the header bits go first
+static void svf_scan(int ir, uint32_t line)
+{
+    scan_para_t *head = ir ? &para_hir : &para_hdr;
+    scan_para_t *data = ir ? &para_sir : &para_sdr;
+    scan_para_t *tail = ir ? &para_tir : &para_tdr;
+    scan_para_t *part[3] = {head, data, tail};
+    uint32_t bits = head->len + data->len + tail->len;
+    uint32_t bytes = (bits + 7) >> 3;
+    uint32_t pos = 0, i;
+    int compare = head->has_tdo || data->has_tdo || tail->has_tdo;
+
+    if (!bits)
+        return;
+    if (bytes > svf_buf_size)
+    {
+        for (i = 0; i < 3; i++)
+            svf_buf[i] = xrealloc(svf_buf[i], bytes);
+        svf_buf_size = bytes;
+    }
+    for (i = 0; i < 3; i++)
+        memset(svf_buf[i], 0, bytes);
+    for (i = 0; i < 3; i++)
+    {
+        bits_copy(svf_buf[0], pos, part[i]->tdi, part[i]->len);
+        if (part[i]->has_tdo)
+        {
+            bits_copy(svf_buf[1], pos, part[i]->tdo, part[i]->len);
+            bits_copy(svf_buf[2], pos, part[i]->mask, part[i]->len);
+        }
+        pos += part[i]->len;
+    }
+    emit_scan(ir, bits, svf_buf[0], compare ? svf_buf[1] : NULL, svf_buf[2], 1, 1,
+              ir ? svf_endir : svf_enddr, 0, 0, line);
+}
+
+// RUNTEST [run_state] run_count run_clk [min_time SEC [MAXIMUM max_time SEC]] [ENDSTATE end_state]
+// RUNTEST [run_state] min_time SEC [MAXIMUM max_time SEC] [ENDSTATE end_state]
+static int svf_runtest(char **tok, int cnt)
+{
+    double tck = 0, us = 0, val;
+    int i = 1, state;
+
+    if ((cnt > i) && ((state = svf_state(tok[i])) >= 0))
+    {
+        svf_run_state = (uint32_t)state;
+        svf_run_end = (uint32_t)state;
+        i++;
+    }
+    while (i < cnt)
+    {
+        if (!strcmp(tok[i], "ENDSTATE") && ((i + 1) < cnt) && ((state = svf_state(tok[i + 1])) >= 0))
+        {
+            svf_run_end = (uint32_t)state;
+            i += 2;
+        }
+        else if (!strcmp(tok[i], "MAXIMUM") && ((i + 2) < cnt))
+        {
+            i += 3;
+        }
+        else if ((i + 1) < cnt)
+        {
+            val = strtod(tok[i], NULL);
+            if (!strcmp(tok[i + 1], "TCK") || !strcmp(tok[i + 1], "SCK"))
+                tck = val;
+            else if (!strcmp(tok[i + 1], "SEC"))
+                us = val * 1000000.0;
+            else
+                return -1;
+            i += 2;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    if (tck > 4294967295.0)
+        tck = 4294967295.0;
+    if (us > 4294967295.0)
+        us = 4294967295.0;
+    emit_runtest(svf_run_state, svf_run_end, (uint32_t)tck, (uint32_t)(us + 0.999));
+    return 0;
+}
+
+static int svf_statement(char **tok, int cnt, uint32_t line)
+{
+    static int freq_note = 0;
+    int state, i;
+
+    if (!strcmp(tok[0], "SIR") || !strcmp(tok[0], "SDR"))
+    {
+        int ir = (tok[0][1] == 'I');
+
+        if (svf_para(tok, cnt, ir ? &para_sir : &para_sdr, 0))
+            return -1;
+        svf_scan(ir, line);
+    }
+    else if (!strcmp(tok[0], "HIR"))
+        return svf_para(tok, cnt, &para_hir, 1);
+    else if (!strcmp(tok[0], "HDR"))
+        return svf_para(tok, cnt, &para_hdr, 1);
+    else if (!strcmp(tok[0], "TIR"))
+        return svf_para(tok, cnt, &para_tir, 1);
+    else if (!strcmp(tok[0], "TDR"))
+        return svf_para(tok, cnt, &para_tdr, 1);
+    else if (!strcmp(tok[0], "ENDIR") || !strcmp(tok[0], "ENDDR"))
+    {
+        if ((cnt != 2) || ((state = svf_state(tok[1])) < 0))
+            return -1;
+        if (tok[0][3] == 'I')
+            svf_endir = (uint32_t)state;
+        else
+            svf_enddr = (uint32_t)state;
+    }
+    else if (!strcmp(tok[0], "STATE"))
+    {
+        for (i = 1; i < cnt; i++)
+        {
+            if ((state = svf_state(tok[i])) < 0)
+                return -1;
+            emit_state((uint32_t)state);
+        }
+    }
+    else if (!strcmp(tok[0], "RUNTEST"))
+        return svf_runtest(tok, cnt);
+    else if (!strcmp(tok[0], "TRST"))
+    {
+        if (cnt != 2)
+            return -1;
+        if (!strcmp(tok[1], "ON"))
+            emit_trst(SVF_TRST_ON);
+        else if (!strcmp(tok[1], "OFF"))
+            emit_trst(SVF_TRST_OFF);
+        else if (!strcmp(tok[1], "Z"))
+            emit_trst(SVF_TRST_Z);
+        else if (!strcmp(tok[1], "ABSENT"))
+            emit_trst(SVF_TRST_ABSENT);
+        else
+            return -1;
+    }
+    else if (!strcmp(tok[0], "FREQUENCY"))
+    {
+        if (!freq_note)
+            printf("Note: FREQUENCY is not packed, set the clock by DAP_SWJ_Clock\n");
+        freq_note = 1;
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+static int svf_comment(const char *p)
+{
+    return (p[0] == '!') || ((p[0] == '/') && (p[1] == '/'));
+}
+
+/*
+ * Split the text into statements, comments start with ! or //, a parenthesised
+ * value is one token with the white space removed. Keywords are upper-cased.
+ */
+static int svf_parse(const char *text)
+{
+    char *tok[SVF_TOKENS_MAX];
+    char *buf, *w;
+    const char *p = text;
+    uint32_t line = 1, stmt_line = 1;
+    int cnt = 0, ret = -1;
+
+    buf = xrealloc(NULL, strlen(text) + 1);
+    w = buf;
+    while (*p)
+    {
+        if (svf_comment(p))
+        {
+            while (*p && (*p != '\n'))
+                p++;
+            continue;
+        }
+        if (isspace((unsigned char)*p))
+        {
+            if (*p++ == '\n')
+                line++;
+            continue;
+        }
+        if (*p == ';')
+        {
+            p++;
+            if (cnt && svf_statement(tok, cnt, stmt_line))
+            {
+                printf("Error: line %u, unsupported or malformed %s\n", stmt_line, tok[0]);
+                goto end;
+            }
+            cnt = 0;
+            w = buf;
+            continue;
+        }
+        if (cnt == SVF_TOKENS_MAX)
+        {
+            printf("Error: line %u, too many tokens\n", stmt_line);
+            goto end;
+        }
+        if (!cnt)
+            stmt_line = line;
+        tok[cnt++] = w;
+        if (*p == '(')
+        {
+            *w++ = *p++;
+            while (*p && (*p != ')'))
+            {
+                if (*p == '\n')
+                    line++;
+                if (!isspace((unsigned char)*p))
+                    *w++ = *p;
+                p++;
+            }
+            if (!*p)
+                break;
+            p++;
+        }
+        else
+        {
+            while (*p && !isspace((unsigned char)*p) && (*p != ';') && (*p != '(') && !svf_comment(p))
+                *w++ = (char)toupper((unsigned char)*p++);
+        }
+        *w++ = '\0';
+    }
+    if (cnt)
+        printf("Error: line %u, statement is not terminated\n", stmt_line);
+    else
+        ret = 0;
+
+end:
+    free(buf);
+    return ret;
+}
+
+/* ---------------------------------------- XSVF ---------------------------------------- */
+
+static const uint8_t *xsvf_data;
+static uint32_t xsvf_len;
+static uint32_t xsvf_pos;
+
+static int xsvf_need(uint32_t len)
+{
+    if ((xsvf_len - xsvf_pos) < len)
+    {
+        printf("Error: XSVF ends inside a command at 0x%X\n", xsvf_pos);
+        return -1;
+    }
+    return 0;
+}
+
+static uint32_t xsvf_u32(void)
+{
+    const uint8_t *p = xsvf_data + xsvf_pos;
+
+    xsvf_pos += 4;
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// XSVF values are big-endian byte streams, the scan bits are LSB first
+static int xsvf_bits(uint8_t *buf, uint32_t bits)
+{
+    uint32_t bytes = (bits + 7) >> 3, i;
+
+    if (xsvf_need(bytes))
+        return -1;
+    for (i = 0; i < bytes; i++)
+        buf[i] = xsvf_data[xsvf_pos + bytes - 1 - i];
+    xsvf_pos += bytes;
+    return 0;
+}
+
+static int xsvf_parse(void)
+{
+    uint8_t *tdi = NULL, *tdo = NULL, *mask = NULL, *ir = NULL;
+    uint32_t sdrsize = 0, repeat = 0, runtest = 0, endir = TAP_IDLE, enddr = TAP_IDLE;
+    uint32_t cmd_pos, len, wait_state, end_state;
+    uint8_t cmd;
+    int ret = -1;
+
+    while (xsvf_pos < xsvf_len)
+    {
+        cmd_pos = xsvf_pos;
+        cmd = xsvf_data[xsvf_pos++];
+        switch (cmd)
+        {
+            case XCOMPLETE:
+                ret = 0;
+                goto end;
+            case XTDOMASK:
+                if (xsvf_bits(mask, sdrsize))
+                    goto end;
+                break;
+            case XSIR:
+            case XSIR2:
+                if (xsvf_need((cmd == XSIR) ? 1 : 2))
+                    goto end;
+                len = xsvf_data[xsvf_pos++];
+                if (cmd == XSIR2)
+                    len = (len << 8) | xsvf_data[xsvf_pos++];
+                ir = xrealloc(ir, (len + 7) >> 3);
+                if (!len || xsvf_bits(ir, len))
+                    goto end;
+                emit_scan(1, len, ir, NULL, NULL, 1, 1, endir, 0, runtest, cmd_pos);
+                break;
+            case XSDR:
+            case XSDRTDO:
+                if (xsvf_bits(tdi, sdrsize) || ((cmd == XSDRTDO) && xsvf_bits(tdo, sdrsize)))
+                    goto end;
+                emit_scan(0, sdrsize, tdi, tdo, mask, 1, 1, enddr, repeat, runtest, cmd_pos);
+                break;
+            case XSDRB:
+            case XSDRC:
+            case XSDRE:
+                if (xsvf_bits(tdi, sdrsize))
+                    goto end;
+                emit_scan(0, sdrsize, tdi, NULL, NULL, cmd == XSDRB, cmd == XSDRE, enddr, 0, 0, cmd_pos);
+                break;
+            case XSDRTDOB:
+            case XSDRTDOC:
+            case XSDRTDOE:
+                if (xsvf_bits(tdi, sdrsize) || xsvf_bits(tdo, sdrsize))
+                    goto end;
+                emit_scan(0, sdrsize, tdi, tdo, mask, cmd == XSDRTDOB, cmd == XSDRTDOE, enddr, 0, 0, cmd_pos);
+                break;
+            case XRUNTEST:
+                if (xsvf_need(4))
+                    goto end;
+                runtest = xsvf_u32();
+                break;
+            case XREPEAT:
+                if (xsvf_need(1))
+                    goto end;
+                repeat = xsvf_data[xsvf_pos++];
+                break;
+            case XSDRSIZE:
+                if (xsvf_need(4))
+                    goto end;
+                sdrsize = xsvf_u32();
+                tdi = xrealloc(tdi, (sdrsize + 7) >> 3);
+                tdo = xrealloc(tdo, (sdrsize + 7) >> 3);
+                mask = xrealloc(mask, (sdrsize + 7) >> 3);
+                memset(tdo, 0, (sdrsize + 7) >> 3);
+                memset(mask, 0xFF, (sdrsize + 7) >> 3);
+                if (!sdrsize)
+                {
+                    printf("Error: XSDRSIZE 0 at 0x%X\n", cmd_pos);
+                    goto end;
+                }
+                break;
+            case XSTATE:
+                if (xsvf_need(1) || (xsvf_data[xsvf_pos] >= TAP_STATES))
+                    goto end;
+                emit_state(xsvf_data[xsvf_pos++]);
+                break;
+            case XENDIR:
+            case XENDDR:
+                if (xsvf_need(1))
+                    goto end;
+                if (cmd == XENDIR)
+                    endir = xsvf_data[xsvf_pos++] ? TAP_IRPAUSE : TAP_IDLE;
+                else
+                    enddr = xsvf_data[xsvf_pos++] ? TAP_DRPAUSE : TAP_IDLE;
+                break;
+            case XCOMMENT:
+                while ((xsvf_pos < xsvf_len) && xsvf_data[xsvf_pos])
+                    xsvf_pos++;
+                xsvf_pos++;
+                break;
+            case XWAIT:
+                if (xsvf_need(6))
+                    goto end;
+                wait_state = xsvf_data[xsvf_pos++];
+                end_state = xsvf_data[xsvf_pos++];
+                if ((wait_state >= TAP_STATES) || (end_state >= TAP_STATES))
+                    goto end;
+                emit_runtest(wait_state, end_state, 0, xsvf_u32());
+                break;
+            default:
+                printf("Error: unsupported XSVF command 0x%02X at 0x%X\n", cmd, cmd_pos);
+                goto end;
+        }
+    }
+    printf("Warning: XSVF ends without XCOMPLETE\n");
+    ret = 0;
+
+end:
+    if (ret)
+        printf("Error: malformed XSVF command 0x%02X at 0x%X\n", cmd, cmd_pos);
+    free(tdi);
+    free(tdo);
+    free(mask);
+    free(ir);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *src;
+    char *data;
+    long size;
+    size_t name_len;
+    int xsvf, ret;
+
+    if ((argc != 3) && (argc != 4))
+    {
+        printf("Usage: %s <input file name> <output file name> [scan map file name]\n", argv[0]);
+        return -1;
+    }
+
+    src = fopen(argv[1], "rb");
+    if (!src)
+    {
+        perror("Error: Source file does not exist");
+        return -1;
+    }
+    fseek(src, 0, SEEK_END);
+    size = ftell(src);
+    fseek(src, 0, SEEK_SET);
+    data = malloc((size_t)size + 1);
+    if (!data)
+    {
+        printf("Error: Out of memory\n");
+        fclose(src);
+        return -1;
+    }
+    if (fread(data, 1, (size_t)size, src) != (size_t)size)
+    {
+        perror("Error: Failed to read source file");
+        fclose(src);
+        return -1;
+    }
+    fclose(src);
+    data[size] = '\0';
+
+    out_file = fopen(argv[2], "wb");
+    if (!out_file)
+    {
+        perror("Error: Failed to create destination file");
+        return -1;
+    }
+    if (argc == 4)
+    {
+        map_file = fopen(argv[3], "w");
+        if (!map_file)
+        {
+            perror("Error: Failed to create scan map file");
+            return -1;
+        }
+    }
+
+    // The XSVF player starts from Test-Logic-Reset
+    name_len = strlen(argv[1]);
+    xsvf = (name_len > 5) && (!strcmp(argv[1] + name_len - 5, ".xsvf") || !strcmp(argv[1] + name_len - 5, ".XSVF"));
+    if (xsvf)
+    {
+        xsvf_data = (const uint8_t *)data;
+        xsvf_len = (uint32_t)size;
+        emit_state(TAP_RESET);
+        ret = xsvf_parse();
+    }
+    else
+    {
+        ret = svf_parse(data);
+    }
+    frame_flush();
+    fclose(out_file);
+    if (map_file)
+        fclose(map_file);
+    free(data);
+    if (ret)
+        return -1;
+
+    printf("%u operations, %u scans -> %u frames\n", op_cnt, scan_cnt, frame_cnt);
+    return 0;
+}